@@ -0,0 +1,176 @@
+#pragma once
+
+// Optional hardware counters around a timed region, read with
+// perf_event_open.  Nothing is opened unless PERF_COUNTERS is set in the
+// environment; then csv() holds the totals as extra columns for the timing
+// line:
+//
+//   seconds,cycles,instructions,l1d_misses,llc_misses,dtlb_misses,branch_misses
+//
+// Events the machine can't count (no PMU in a VM, perf_event_paranoid > 2)
+// are left empty.  OpenMP builds count every thread of the default team;
+// with PERF_COUNTERS_THREADS=<file> each stop() also appends one row per
+// thread to <file>.  Counts are user space only and scaled when the PMU
+// multiplexes events.
+
+#include <array>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "perf_events.h"
+
+namespace perf {
+
+enum Event { Cycles, Instructions, L1dMisses, LlcMisses, DtlbMisses, BranchMisses, EventCount };
+
+// Negative entries were not counted.
+using Counts = std::array<int64_t, EventCount>;
+
+struct EventInfo {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+};
+
+#define PERF_EVENT_INFO(name, type, config) {name, type, config},
+inline constexpr EventInfo events[] = {PERF_EVENTS(PERF_EVENT_INFO)};
+#undef PERF_EVENT_INFO
+static_assert(std::size(events) == EventCount, "Event must follow PERF_EVENTS");
+
+class Counters {
+public:
+    Counters() {
+        enabled_ = std::getenv("PERF_COUNTERS") != nullptr;
+        totals_.fill(-1);
+        if (!enabled_) return;
+
+        // The team's threads are kept by the OpenMP runtime, so the ones
+        // found here are the ones that run the timed parallel regions.
+        std::vector<pid_t> tids(1, static_cast<pid_t>(syscall(SYS_gettid)));
+#ifdef _OPENMP
+        tids.assign(omp_get_max_threads(), -1);
+        #pragma omp parallel
+        tids[omp_get_thread_num()] = static_cast<pid_t>(syscall(SYS_gettid));
+        std::erase(tids, -1);
+#endif
+        fds_.resize(tids.size());
+        threads_.resize(tids.size());
+        for (size_t t = 0; t < tids.size(); t++) {
+            for (int e = 0; e < EventCount; e++) {
+                fds_[t][e] = open_event(events[e], tids[t]);
+            }
+        }
+    }
+
+    ~Counters() {
+        for (auto& fds : fds_) {
+            for (int fd : fds) {
+                if (fd >= 0) close(fd);
+            }
+        }
+    }
+
+    Counters(const Counters&) = delete;
+    Counters& operator=(const Counters&) = delete;
+
+    bool enabled() const { return enabled_; }
+
+    void start() {
+        each_fd(PERF_EVENT_IOC_RESET);
+        each_fd(PERF_EVENT_IOC_ENABLE);
+    }
+
+    void stop() {
+        each_fd(PERF_EVENT_IOC_DISABLE);
+        totals_.fill(-1);
+        for (size_t t = 0; t < fds_.size(); t++) {
+            for (int e = 0; e < EventCount; e++) {
+                threads_[t][e] = read_event(fds_[t][e]);
+                if (threads_[t][e] >= 0) totals_[e] = (totals_[e] < 0 ? 0 : totals_[e]) + threads_[t][e];
+            }
+        }
+        if (const char* path = std::getenv("PERF_COUNTERS_THREADS")) write_threads(path);
+    }
+
+    const Counts& totals() const { return totals_; }
+    const std::vector<Counts>& threads() const { return threads_; }
+
+    // ",cycles,instructions,..." of the last stop(), "" when disabled.
+    std::string csv() const { return enabled_ ? csv(totals_) : std::string(); }
+
+    static std::string csv(const Counts& counts) {
+        std::string out;
+        for (int64_t v : counts) {
+            out += ',';
+            if (v >= 0) out += std::to_string(v);
+        }
+        return out;
+    }
+
+    static std::string header() {
+        std::string out;
+        for (const auto& e : events) {
+            out += ',';
+            out += e.name;
+        }
+        return out;
+    }
+
+private:
+    static int open_event(const EventInfo& event, pid_t tid) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event.type;
+        attr.config = event.config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0));
+    }
+
+    static int64_t read_event(int fd) {
+        uint64_t v[3]; // value, time enabled, time running
+        if (fd < 0 || read(fd, v, sizeof(v)) != sizeof(v) || v[2] == 0) return -1;
+        if (v[2] < v[1]) return static_cast<int64_t>(static_cast<double>(v[0]) * v[1] / v[2]);
+        return static_cast<int64_t>(v[0]);
+    }
+
+    void each_fd(unsigned long request) {
+        for (auto& fds : fds_) {
+            for (int fd : fds) {
+                if (fd >= 0) ioctl(fd, request, 0);
+            }
+        }
+    }
+
+    void write_threads(const char* path) const {
+        std::ifstream probe(path);
+        bool fresh = !probe.good() || probe.peek() == std::ifstream::traits_type::eof();
+        std::ofstream out(path, std::ios::app);
+        if (fresh) out << "program,thread" << header() << "\n";
+        for (size_t t = 0; t < threads_.size(); t++) {
+            out << program_invocation_short_name << "," << t << csv(threads_[t]) << "\n";
+        }
+    }
+
+    bool enabled_ = false;
+    std::vector<std::array<int, EventCount>> fds_;
+    std::vector<Counts> threads_;
+    Counts totals_;
+};
+
+} // namespace perf
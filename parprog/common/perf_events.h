@@ -0,0 +1,24 @@
+#ifndef PERF_EVENTS_H
+#define PERF_EVENTS_H
+
+/*
+ * The hardware events counted by lab1's --perf (lib/perf.c) and by the
+ * PERF_COUNTERS columns of lab2 / lab3 (perf_counters.hpp), in column
+ * order, as X(name, perf_event_attr type, config).  Plain C so both
+ * sides expand the one list.
+ */
+
+#include <linux/perf_event.h>
+
+#define PERF_READ_MISS(cache) \
+    ((cache) | PERF_COUNT_HW_CACHE_OP_READ << 8 | PERF_COUNT_HW_CACHE_RESULT_MISS << 16)
+
+#define PERF_EVENTS(X)                                                                  \
+    X("cycles",        PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES)                     \
+    X("instructions",  PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS)                   \
+    X("l1d_misses",    PERF_TYPE_HW_CACHE, PERF_READ_MISS(PERF_COUNT_HW_CACHE_L1D))      \
+    X("llc_misses",    PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES)                   \
+    X("dtlb_misses",   PERF_TYPE_HW_CACHE, PERF_READ_MISS(PERF_COUNT_HW_CACHE_DTLB))     \
+    X("branch_misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES)
+
+#endif
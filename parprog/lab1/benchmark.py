@@ -4,18 +4,23 @@ import csv
 import subprocess
 import sys
 from pathlib import Path
-from typing import Dict, List, Tuple
+from typing import Dict, List, Optional, Tuple
 
 import numpy as np
 
+from matfile import write_matrix
+
 
 METHODS = [
-    {"name": "slow", "label": "SLOW", "binary": "slow"},
-    {"name": "trancepose", "label": "TRANSPOSE", "binary": "trancepose"},
-    {"name": "block", "label": "BLOCK_TRANSPOSE", "binary": "block"},
-    {"name": "strass", "label": "STRASSEN_TRANSPOSE", "binary": "strass"},
-    {"name": "parallel", "label": "PARALLEL_STRASSEN_TRANSPOSE", "binary": "parallel"},
-    {"name": "simd", "label": "SIMD_PARALLEL_STRASSEN_TRANSPOSE", "binary": "simd"},
+    {"name": "slow", "label": "SLOW", "algo": "slow"},
+    {"name": "trancepose", "label": "TRANSPOSE", "algo": "transpose"},
+    {"name": "block", "label": "BLOCK_TRANSPOSE", "algo": "block"},
+    {"name": "strass", "label": "STRASSEN_TRANSPOSE", "algo": "strass"},
+    {"name": "parallel", "label": "PARALLEL_STRASSEN_TRANSPOSE", "algo": "parallel"},
+    {"name": "simd", "label": "SIMD_PARALLEL_STRASSEN_TRANSPOSE", "algo": "simd"},
+    {"name": "gemm_packed", "label": "GEMM_PACKED", "algo": "packed"},
+    {"name": "winograd", "label": "WINOGRAD_TRANSPOSE", "algo": "winograd"},
+    {"name": "morton", "label": "WINOGRAD_MORTON", "algo": "morton"},
 ]
 
 
@@ -49,6 +54,12 @@ def parse_args() -> argparse.Namespace:
         help="Skip rebuilding binaries with make.",
     )
     parser.add_argument("--seed", type=int, default=0, help="Seed for random matrix generation.")
+    parser.add_argument(
+        "--format",
+        choices=["bin", "text"],
+        default="bin",
+        help="Matrix file format for inputs and outputs (text is the legacy .dat format).",
+    )
     parser.add_argument(
         "--log-file",
         type=Path,
@@ -61,6 +72,50 @@ def parse_args() -> argparse.Namespace:
         default=Path("benchmark_timings.csv"),
         help="Where to write parsed timing CSV.",
     )
+    parser.add_argument("--warmup", type=int, default=1, help="Untimed runs before the timed ones.")
+    parser.add_argument("--reps", type=int, default=5, help="Timed runs per method and size (the median is reported).")
+    parser.add_argument(
+        "--perf",
+        action="store_true",
+        help="Record hardware counters (cycles, instructions, cache/TLB/branch misses) as extra CSV columns.",
+    )
+    parser.add_argument(
+        "--verify",
+        action="store_true",
+        help="Check every output with build/verify (Freivalds' test, O(N^2) per run) and stop on a mismatch.",
+    )
+    parser.add_argument(
+        "--phases",
+        action="store_true",
+        help="Record per-phase timings (load, alloc, transpose, compute, combine, write) and plot them as stacked bars.",
+    )
+    parser.add_argument(
+        "--phases-file",
+        type=Path,
+        default=Path("benchmark_phases.csv"),
+        help="Where the binary appends per-phase timings with --phases.",
+    )
+    parser.add_argument(
+        "--baseline",
+        type=Path,
+        help="CSV from an earlier run to compare against; slower medians are flagged as regressions.",
+    )
+    parser.add_argument(
+        "--save-baseline",
+        type=Path,
+        help="Also copy this run's CSV here for later --baseline comparisons.",
+    )
+    parser.add_argument(
+        "--threshold",
+        type=float,
+        default=0.10,
+        help="Relative slowdown of the median that counts as a regression.",
+    )
+    parser.add_argument(
+        "--fail-on-regression",
+        action="store_true",
+        help="Exit with status 2 when a regression is flagged.",
+    )
     parser.add_argument(
         "--plot-file",
         type=Path,
@@ -80,21 +135,16 @@ def size_list(args: argparse.Namespace) -> List[int]:
     return sizes
 
 
-def write_matrix(path: Path, matrix: np.ndarray) -> None:
-    flat = matrix.ravel()
-    with path.open("w") as f:
-        f.write(f"{matrix.shape[0]}\n")
-        # Write in chunks to avoid holding a giant string in memory for large matrices.
-        for start in range(0, flat.size, 1024):
-            chunk = flat[start : start + 1024]
-            f.write(" ".join(str(int(val)) for val in chunk))
-            f.write(" ")
+def file_suffix(fmt: str) -> str:
+    return ".bin" if fmt == "bin" else ".dat"
 
 
-def generate_inputs(size: int, data_dir: Path, rng: np.random.Generator, regen: bool) -> Tuple[Path, Path]:
+def generate_inputs(
+    size: int, data_dir: Path, rng: np.random.Generator, regen: bool, fmt: str
+) -> Tuple[Path, Path]:
     data_dir.mkdir(parents=True, exist_ok=True)
-    a_path = data_dir / f"A_{size}.dat"
-    b_path = data_dir / f"B_{size}.dat"
+    a_path = data_dir / f"A_{size}{file_suffix(fmt)}"
+    b_path = data_dir / f"B_{size}{file_suffix(fmt)}"
 
     if regen or not (a_path.exists() and b_path.exists()):
         print(f"[data] Generating inputs for size {size}")
@@ -123,16 +173,42 @@ def run_method(
     output_dir: Path,
     build_dir: Path,
     log_file: Path,
+    fmt: str,
+    warmup: int,
+    reps: int,
+    perf: bool,
+    phases_file: Optional[Path],
+    verify: bool,
 ) -> None:
     output_dir.mkdir(parents=True, exist_ok=True)
-    binary = build_dir / method["binary"]
+    binary = build_dir / "matmul"
     if not binary.exists():
         raise FileNotFoundError(f"Binary not found: {binary}. Did you run make?")
 
-    out_path = output_dir / f"{method['name']}_{size}.dat"
-    cmd = [str(binary), str(a_path), str(b_path), str(out_path), str(log_file)]
+    out_path = output_dir / f"{method['name']}_{size}{file_suffix(fmt)}"
+    cmd = [
+        str(binary),
+        f"--algo={method['algo']}",
+        f"--warmup={warmup}",
+        f"--reps={reps}",
+        *(["--perf"] if perf else []),
+        *([f"--phases={phases_file}"] if phases_file else []),
+        str(a_path),
+        str(b_path),
+        str(out_path),
+        str(log_file),
+    ]
     print(f"[run] {method['label']:28s} size={size}")
     subprocess.run(cmd, check=True)
+    if verify:
+        subprocess.run([str(build_dir / "verify"), str(a_path), str(b_path), str(out_path)], check=True)
+
+
+STAT_FIELDS = {"reps": int, "p10": float, "p90": float, "stddev": float, "gflops": float, "gbps": float}
+# Per-call hardware counters logged by --perf; empty when the machine can't count the event.
+PERF_FIELDS = ["cycles", "instructions", "l1d_misses", "llc_misses", "dtlb_misses", "branch_misses", "ipc"]
+STAT_FIELDS.update({name: float for name in PERF_FIELDS})
+CSV_FIELDS = ["method", "size", "seconds", "p10", "p90", "stddev", "reps", "gflops", "gbps"] + PERF_FIELDS
 
 
 def parse_log(log_file: Path) -> List[dict]:
@@ -142,24 +218,174 @@ def parse_log(log_file: Path) -> List[dict]:
 
     with log_file.open() as f:
         for line in f:
+            # method,size,median_seconds[,alloc_seconds,touch_seconds][,key=value...]
             parts = line.strip().split(",")
-            if len(parts) != 3:
+            if len(parts) < 3:
                 continue
-            method, size_str, seconds_str = parts
+            method, size_str, seconds_str = parts[:3]
             try:
-                records.append({"method": method, "size": int(size_str), "seconds": float(seconds_str)})
+                record = {"method": method, "size": int(size_str), "seconds": float(seconds_str)}
             except ValueError:
                 continue
+            for part in parts[3:]:
+                key, sep, value = part.partition("=")
+                if sep and key in STAT_FIELDS and value:
+                    record[key] = STAT_FIELDS[key](value)
+            # Single-shot logs carry no spread: the one sample is every percentile.
+            record.setdefault("reps", 1)
+            record.setdefault("p10", record["seconds"])
+            record.setdefault("p90", record["seconds"])
+            record.setdefault("stddev", 0.0)
+            records.append(record)
     return records
 
 
+def perf_cell(row: dict, name: str) -> str:
+    if name not in row:
+        return ""
+    return f"{row[name]:.3f}" if name == "ipc" else f"{row[name]:.0f}"
+
+
 def write_csv(records: List[dict], csv_file: Path) -> None:
     csv_file.parent.mkdir(parents=True, exist_ok=True)
     with csv_file.open("w", newline="") as f:
         writer = csv.writer(f)
-        writer.writerow(["method", "size", "seconds"])
+        writer.writerow(CSV_FIELDS)
         for row in sorted(records, key=lambda r: (r["method"], r["size"])):
-            writer.writerow([row["method"], row["size"], f"{row['seconds']:.9f}"])
+            writer.writerow(
+                [
+                    row["method"],
+                    row["size"],
+                    f"{row['seconds']:.9f}",
+                    f"{row['p10']:.9f}",
+                    f"{row['p90']:.9f}",
+                    f"{row['stddev']:.9f}",
+                    row["reps"],
+                    f"{row.get('gflops', 0.0):.3f}",
+                    f"{row.get('gbps', 0.0):.3f}",
+                    *(perf_cell(row, name) for name in PERF_FIELDS),
+                ]
+            )
+
+
+def read_csv(csv_file: Path) -> List[dict]:
+    records: List[dict] = []
+    with csv_file.open(newline="") as f:
+        for row in csv.DictReader(f):
+            seconds = float(row["seconds"])
+            records.append(
+                {
+                    "method": row["method"],
+                    "size": int(row["size"]),
+                    "seconds": seconds,
+                    # Baselines written before the spread columns existed.
+                    "p10": float(row.get("p10") or seconds),
+                    "p90": float(row.get("p90") or seconds),
+                }
+            )
+    return records
+
+
+def compare_baseline(records: List[dict], baseline: List[dict], threshold: float) -> List[str]:
+    """
+    A run regresses when its median is more than `threshold` slower than the
+    baseline median and its p10..p90 band lies entirely above the baseline's,
+    so a noisy run that merely overlaps the old spread is not flagged.
+    """
+    old = {(r["method"], r["size"]): r for r in baseline}
+    regressions: List[str] = []
+    for row in sorted(records, key=lambda r: (r["method"], r["size"])):
+        ref = old.get((row["method"], row["size"]))
+        if ref is None or ref["seconds"] <= 0:
+            continue
+        change = row["seconds"] / ref["seconds"] - 1
+        flag = ""
+        if change > threshold and row["p10"] > ref["p90"]:
+            flag = "  REGRESSION"
+            regressions.append(f"{row['method']} size={row['size']}")
+        elif change < -threshold and row["p90"] < ref["p10"]:
+            flag = "  improved"
+        print(
+            f"[baseline] {row['method']:32s} {row['size']:6d} "
+            f"{ref['seconds']:.6f}s -> {row['seconds']:.6f}s ({change:+.1%}){flag}"
+        )
+    return regressions
+
+
+PHASE_ORDER = ["load", "alloc", "touch", "setup", "transpose", "compute", "combine", "write"]
+
+
+def read_phases(phases_file: Path) -> Dict[Tuple[str, str], Dict[str, float]]:
+    """(method, size) -> phase -> seconds; a later run of the same pair replaces the earlier one."""
+    runs: Dict[Tuple[str, str], Dict[str, float]] = {}
+    if not phases_file.exists():
+        return runs
+    with phases_file.open(newline="") as f:
+        for row in csv.DictReader(f):
+            key = (row["label"], row["size"])
+            if row["phase"] == PHASE_ORDER[0]:
+                runs[key] = {}
+            runs.setdefault(key, {})[row["phase"]] = float(row["seconds"])
+    return runs
+
+
+def plot_phases(runs: Dict[Tuple[str, str], Dict[str, float]], plot_file: Path) -> None:
+    """
+    One panel per size with a stacked bar per method: the phases, and next
+    to it the strass recursion levels when they were recorded.
+    """
+    try:
+        import matplotlib.pyplot as plt
+    except ImportError:  # pragma: no cover - only triggered when matplotlib missing
+        print("matplotlib is not installed; skipping plot. Install it with `pip install matplotlib`.", file=sys.stderr)
+        return
+    if not runs:
+        print("No phase data found; skipping phase plot.")
+        return
+
+    sizes = sorted({size for _, size in runs}, key=lambda s: [int(x) for x in s.split("x")])
+    fig, axes = plt.subplots(len(sizes), 1, figsize=(10, 4 * len(sizes)), squeeze=False)
+    for ax, size in zip(axes[:, 0], sizes):
+        methods = sorted(method for method, s in runs if s == size)
+        bottoms = [0.0] * len(methods)
+        for phase in PHASE_ORDER:
+            heights = [runs[(method, size)].get(phase, 0.0) for method in methods]
+            ax.bar(methods, heights, bottom=bottoms, label=phase)
+            bottoms = [b + h for b, h in zip(bottoms, heights)]
+        ax.set_title(f"Time by phase, size {size}")
+        ax.set_ylabel("Seconds")
+        ax.tick_params(axis="x", labelrotation=30)
+        ax.legend(fontsize="small")
+        ax.grid(True, axis="y", linestyle="--", alpha=0.4)
+    fig.tight_layout()
+    plot_file.parent.mkdir(parents=True, exist_ok=True)
+    fig.savefig(plot_file, dpi=200)
+    print(f"[plot] Saved phase plot to {plot_file}")
+
+    levels = {key: phases for key, phases in runs.items() if "level0" in phases}
+    if not levels:
+        return
+    fig, ax = plt.subplots(figsize=(10, 6))
+    keys = sorted(levels)
+    names = [f"{method}\n{size}" for method, size in keys]
+    bottoms = [0.0] * len(keys)
+    depth = 0
+    while any(f"level{depth}" in levels[key] for key in keys):
+        # level d includes everything below it: stack the self time of each depth
+        heights = [
+            levels[key].get(f"level{depth}", 0.0) - levels[key].get(f"level{depth + 1}", 0.0) for key in keys
+        ]
+        ax.bar(names, heights, bottom=bottoms, label=f"depth {depth}")
+        bottoms = [b + h for b, h in zip(bottoms, heights)]
+        depth += 1
+    ax.set_title("Strassen recursion: time spent at each depth")
+    ax.set_ylabel("Seconds")
+    ax.legend(fontsize="small")
+    ax.grid(True, axis="y", linestyle="--", alpha=0.4)
+    fig.tight_layout()
+    levels_file = plot_file.with_name(plot_file.stem + "_levels" + plot_file.suffix)
+    fig.savefig(levels_file, dpi=200)
+    print(f"[plot] Saved recursion level plot to {levels_file}")
 
 
 def plot(records: List[dict], plot_file: Path) -> None:
@@ -179,12 +405,17 @@ def plot(records: List[dict], plot_file: Path) -> None:
     sizes = sorted({r["size"] for r in records})
     for method in methods:
         subset = sorted((r for r in records if r["method"] == method), key=lambda r: r["size"])
-        plt.plot([r["size"] for r in subset], [r["seconds"] for r in subset], marker="o", label=method)
+        seconds = [r["seconds"] for r in subset]
+        yerr = [
+            [s - r["p10"] for s, r in zip(seconds, subset)],
+            [r["p90"] - s for s, r in zip(seconds, subset)],
+        ]
+        plt.errorbar([r["size"] for r in subset], seconds, yerr=yerr, marker="o", capsize=3, label=method)
 
     plt.xscale("log", base=2)
     plt.xticks(sizes, sizes)
     plt.xlabel("Matrix size (N x N)")
-    plt.ylabel("Execution time (s)")
+    plt.ylabel("Median execution time (s), p10-p90 bars")
     plt.title("Matrix multiplication performance")
     plt.grid(True, which="both", linestyle="--", alpha=0.4)
     plt.legend()
@@ -211,7 +442,12 @@ def plot_log(records: List[dict], plot_file: Path) -> None:
     sizes = sorted({r["size"] for r in records})
     for method in methods:
         subset = sorted((r for r in records if r["method"] == method), key=lambda r: r["size"])
-        plt.plot([r["size"] for r in subset], [np.log(r["seconds"]) for r in subset], marker="o", label=method)
+        seconds = [np.log(r["seconds"]) for r in subset]
+        yerr = [
+            [s - np.log(r["p10"]) for s, r in zip(seconds, subset)],
+            [np.log(r["p90"]) - s for s, r in zip(seconds, subset)],
+        ]
+        plt.errorbar([r["size"] for r in subset], seconds, yerr=yerr, marker="o", capsize=3, label=method)
 
     plt.xscale("log", base=2)
     plt.xticks(sizes, sizes)
@@ -234,6 +470,7 @@ def main() -> int:
     log_file = (base_dir / args.log_file).resolve()
     csv_file = (base_dir / args.csv_file).resolve()
     plot_file = (base_dir / args.plot_file).resolve()
+    phases_file = (base_dir / args.phases_file).resolve() if args.phases else None
     log_file.parent.mkdir(parents=True, exist_ok=True)
 
     try:
@@ -247,13 +484,29 @@ def main() -> int:
     build_binaries(base_dir, args.skip_build)
 
     log_file.unlink(missing_ok=True)
+    if phases_file:
+        phases_file.unlink(missing_ok=True)
     rng = np.random.default_rng(args.seed)
 
     for size in sizes:
-        a_path, b_path = generate_inputs(size, data_dir, rng, args.regen_inputs)
+        a_path, b_path = generate_inputs(size, data_dir, rng, args.regen_inputs, args.format)
         for method in selected_methods:
             try:
-                run_method(method, size, a_path, b_path, output_dir, build_dir, log_file)
+                run_method(
+                    method,
+                    size,
+                    a_path,
+                    b_path,
+                    output_dir,
+                    build_dir,
+                    log_file,
+                    args.format,
+                    args.warmup,
+                    args.reps,
+                    args.perf,
+                    phases_file,
+                    args.verify,
+                )
             except subprocess.CalledProcessError as exc:
                 print(f"Command failed ({' '.join(map(str, exc.cmd))}): {exc}", file=sys.stderr)
                 return 1
@@ -268,8 +521,21 @@ def main() -> int:
 
     write_csv(records, csv_file)
     print(f"[csv] Wrote {len(records)} records to {csv_file}")
+    if args.save_baseline:
+        save_path = (base_dir / args.save_baseline).resolve()
+        write_csv(records, save_path)
+        print(f"[baseline] Saved baseline to {save_path}")
     plot(records, plot_file)
     plot_log(records, plot_file.with_name(plot_file.stem + "_log" + plot_file.suffix))
+    if phases_file:
+        plot_phases(read_phases(phases_file), plot_file.with_name(plot_file.stem + "_phases" + plot_file.suffix))
+
+    if args.baseline:
+        regressions = compare_baseline(records, read_csv((base_dir / args.baseline).resolve()), args.threshold)
+        if regressions:
+            print(f"[baseline] {len(regressions)} regression(s): {', '.join(regressions)}", file=sys.stderr)
+            if args.fail_on_regression:
+                return 2
     return 0
 
 
@@ -1,30 +1,37 @@
 import numpy as np
 import sys
 
+from matfile import write_matrix
 
-MATRIX_SIZE = int(sys.argv[1])
-
-MATRIX_A = np.random.randint(0, 256, size=(MATRIX_SIZE, MATRIX_SIZE), dtype=np.uint32)
-MATRIX_B = np.random.randint(0, 256, size=(MATRIX_SIZE, MATRIX_SIZE), dtype=np.uint32)
-MATRIX_C = (MATRIX_A.astype(np.uint64) @ MATRIX_B.astype(np.uint64)).astype(np.uint32)
-
-MATRIX = MATRIX_A.reshape(-1)
-
-with open(sys.argv[2], 'w') as f:
-    f.write(f"{MATRIX_SIZE}\n")
-    for i in MATRIX:
-        f.write(f"{int(i)} ")
-    
-MATRIX = MATRIX_B.reshape(-1)
 
-with open(sys.argv[3], 'w') as f:
-    f.write(f"{MATRIX_SIZE}\n")
-    for i in MATRIX:
-        f.write(f"{int(i)} ")
-
-MATRIX = MATRIX_C.reshape(-1)
-
-with open(sys.argv[4], 'w') as f:
-    f.write(f"{MATRIX_SIZE}\n")
-    for i in MATRIX:
-        f.write(f"{int(i)} ")
+MATRIX_SIZE = int(sys.argv[1])
+# Optional 5th argument: input dtype of binary outputs (u32, u8, i16, i32, f32, f64).
+DTYPE = sys.argv[5] if len(sys.argv) > 5 else "u32"
+# Optional 6th argument: write batches of that many products (binary outputs only).
+COUNT = int(sys.argv[6]) if len(sys.argv) > 6 else 1
+SHAPE = (MATRIX_SIZE, MATRIX_SIZE) if COUNT == 1 else (COUNT, MATRIX_SIZE, MATRIX_SIZE)
+
+# input dtype -> (numpy input type, numpy result type)
+DTYPES = {
+    "u32": (np.uint32, np.uint32),
+    "u8": (np.uint8, np.uint32),
+    "i16": (np.int16, np.int32),
+    "i32": (np.int32, np.int32),
+    "f32": (np.float32, np.float32),
+    "f64": (np.float64, np.float64),
+}
+IN_TYPE, OUT_TYPE = DTYPES[DTYPE]
+
+if np.issubdtype(IN_TYPE, np.floating):
+    MATRIX_A = np.random.uniform(-1, 1, size=SHAPE).astype(IN_TYPE)
+    MATRIX_B = np.random.uniform(-1, 1, size=SHAPE).astype(IN_TYPE)
+    MATRIX_C = (MATRIX_A.astype(np.float64) @ MATRIX_B.astype(np.float64)).astype(OUT_TYPE)
+else:
+    MATRIX_A = np.random.randint(0, 256, size=SHAPE).astype(IN_TYPE)
+    MATRIX_B = np.random.randint(0, 256, size=SHAPE).astype(IN_TYPE)
+    MATRIX_C = (MATRIX_A.astype(np.uint64) @ MATRIX_B.astype(np.uint64)).astype(OUT_TYPE)
+
+# Output format follows the extension: *.bin is binary, anything else is text.
+write_matrix(sys.argv[2], MATRIX_A)
+write_matrix(sys.argv[3], MATRIX_B)
+write_matrix(sys.argv[4], MATRIX_C)
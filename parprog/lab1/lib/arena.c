@@ -0,0 +1,144 @@
+#include <string.h>
+#include <time.h>
+#include <sys/mman.h>
+#include <omp.h>
+
+#include "kernels.h"
+
+/*
+ * Workspace arena: one mapping per calling thread, kept between calls.
+ * Callers reserve the whole size they need up front (only while the arena
+ * is empty, since growing moves it), then push blocks and pop back to a
+ * mark.  Memory is pre-faulted once, so repeated multiplies of the same
+ * size neither allocate nor fault.  Pre-faulting with touch_threads > 1
+ * spreads the first touch over a team, so on NUMA machines the pages land
+ * on the nodes of the threads that will use them (--numa).
+ */
+
+#define HUGE_PAGE (2u << 20)
+
+static _Thread_local MM_ARENA arena;
+static _Thread_local MATMUL_STATS stats;
+
+double mm_now(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec*1e-9;
+}
+
+MM_ARENA* mm_arena(void){
+    return &arena;
+}
+
+MATMUL_STATS* mm_stats(void){
+    return &stats;
+}
+
+void matmul_get_stats(MATMUL_STATS* out){
+    *out = stats;
+}
+
+double mm_phase(MATMUL_PHASE phase, double t0){
+    double t = mm_now();
+    stats.phase_seconds[phase] += t - t0;
+    return t;
+}
+
+static size_t round_up(size_t x, size_t to){
+    return (x + to - 1) / to * to;
+}
+
+static int arena_map(MM_ARENA* a, size_t bytes){
+    size_t len = round_up(bytes, HUGE_PAGE);
+
+    void* p = MAP_FAILED;
+    int huge = MATMUL_HUGE_HUGETLB;
+    if (!a->small_pages) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    }
+    if (p == MAP_FAILED) {
+        p = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) return -1;
+        if (a->small_pages) {
+            madvise(p, len, MADV_NOHUGEPAGE);
+            huge = MATMUL_HUGE_NONE;
+        } else {
+            huge = madvise(p, len, MADV_HUGEPAGE) ? MATMUL_HUGE_NONE : MATMUL_HUGE_THP;
+        }
+    }
+
+    a->base = p;
+    a->cap = len;
+    a->top = 0;
+    a->touched = 0;
+    a->huge = huge;
+    return 0;
+}
+
+/* Zeroes [from, to) of the arena, split into one contiguous chunk per thread. */
+static void arena_touch(MM_ARENA* a, size_t from, size_t to, int threads){
+    if (threads <= 1) {
+        memset(a->base + from, 0, to - from);
+        return;
+    }
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        size_t chunk = ((to - from + nt - 1) / nt + 4095) & ~(size_t)4095;
+        size_t lo = from + chunk * t, hi = lo + chunk < to ? lo + chunk : to;
+        if (lo < hi) memset(a->base + lo, 0, hi - lo);
+    }
+}
+
+int mm_arena_reserve(MM_ARENA* a, size_t bytes, int touch_threads){
+    if (a->cap - a->top < bytes) {
+        if (a->top) return -1;
+
+        double t0 = mm_now();
+        mm_arena_release(a);
+        int failed = arena_map(a, bytes);
+        stats.alloc_seconds += mm_now() - t0;
+        if (failed) return -1;
+    }
+
+    size_t end = a->top + bytes;
+    if (end > a->touched) {
+        double t0 = mm_now();
+        arena_touch(a, a->touched, end, touch_threads);
+        a->touched = end;
+        stats.touch_seconds += mm_now() - t0;
+    }
+
+    stats.workspace_bytes += bytes;
+    stats.huge_pages = a->huge;
+    return 0;
+}
+
+void* mm_arena_push(MM_ARENA* a, size_t bytes){
+    size_t len = MM_ARENA_LEN(bytes ? bytes : 1);
+    if (a->cap - a->top < len) return NULL;
+    void* p = a->base + a->top;
+    a->top += len;
+    return p;
+}
+
+void mm_arena_pop(MM_ARENA* a, size_t mark){
+    a->top = mark;
+}
+
+size_t mm_arena_resident(const MM_ARENA* a){
+    if (a->huge == MATMUL_HUGE_HUGETLB) return a->cap;
+    return round_up(a->touched, a->huge == MATMUL_HUGE_THP ? HUGE_PAGE : 4096);
+}
+
+void mm_arena_release(MM_ARENA* a){
+    int small_pages = a->small_pages;
+    if (a->base) munmap(a->base, a->cap);
+    memset(a, 0, sizeof(*a));
+    a->small_pages = small_pages;
+}
+
+void matmul_release_workspace(void){
+    mm_arena_release(&arena);
+}
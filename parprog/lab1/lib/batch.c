@@ -0,0 +1,157 @@
+#include <errno.h>
+#include <string.h>
+#include <immintrin.h>
+#include <omp.h>
+
+#include "kernels.h"
+
+/*
+ * Batched multiplies: many independent small products, shared across the
+ * team one product per iteration.  Each product is sequential, so the cost
+ * of a team and of workspace setup is paid once per batch rather than once
+ * per product.
+ *
+ * Small products read B row-major (no B^T copy): a row of C is built 32
+ * columns at a time in four AVX2 accumulators from broadcasts of A(i, p)
+ * times row p of B.  The square sizes in benchmark_data/ get their own
+ * instances with the dimensions as constants; anything else runs the same
+ * code with runtime dimensions.  Products with a side above BATCH_SMALL go
+ * through a single-threaded packed plan on the thread's own arena.
+ */
+
+#define BATCH_SMALL 256
+
+static inline __attribute__((always_inline))
+void small_mm(const uint* A, const uint* B, uint* C, size_t m, size_t k, size_t n){
+    for(size_t i = 0; i < m; i++){
+        const uint* a = A + i*k;
+        uint* c = C + i*n;
+        size_t j = 0;
+#ifdef __AVX2__
+        for(; j + 31 < n; j += 32){
+            __m256i c0 = _mm256_setzero_si256();
+            __m256i c1 = _mm256_setzero_si256();
+            __m256i c2 = _mm256_setzero_si256();
+            __m256i c3 = _mm256_setzero_si256();
+            const uint* b = B + j;
+            for(size_t p = 0; p < k; p++, b += n){
+                __m256i x = _mm256_set1_epi32(a[p]);
+                c0 = _mm256_add_epi32(c0, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i*)(b))));
+                c1 = _mm256_add_epi32(c1, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i*)(b + 8))));
+                c2 = _mm256_add_epi32(c2, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i*)(b + 16))));
+                c3 = _mm256_add_epi32(c3, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i*)(b + 24))));
+            }
+            _mm256_storeu_si256((__m256i*)(c + j), c0);
+            _mm256_storeu_si256((__m256i*)(c + j + 8), c1);
+            _mm256_storeu_si256((__m256i*)(c + j + 16), c2);
+            _mm256_storeu_si256((__m256i*)(c + j + 24), c3);
+        }
+        for(; j + 7 < n; j += 8){
+            __m256i c0 = _mm256_setzero_si256();
+            const uint* b = B + j;
+            for(size_t p = 0; p < k; p++, b += n){
+                __m256i x = _mm256_set1_epi32(a[p]);
+                c0 = _mm256_add_epi32(c0, _mm256_mullo_epi32(x, _mm256_loadu_si256((const __m256i*)(b))));
+            }
+            _mm256_storeu_si256((__m256i*)(c + j), c0);
+        }
+#endif
+        for(; j < n; j++){
+            uint sum = 0;
+            for(size_t p = 0; p < k; p++) sum += a[p] * B[p*n+j];
+            c[j] = sum;
+        }
+    }
+}
+
+typedef void (*BATCH_FIXED)(const uint* A, const uint* B, uint* C);
+
+#define MM_BATCH_FIXED(N)                                               \
+static void batch_##N(const uint* A, const uint* B, uint* C){           \
+    small_mm(A, B, C, N, N, N);                                         \
+}
+
+MM_BATCH_FIXED(8)
+MM_BATCH_FIXED(16)
+MM_BATCH_FIXED(32)
+MM_BATCH_FIXED(64)
+MM_BATCH_FIXED(128)
+
+#undef MM_BATCH_FIXED
+
+static BATCH_FIXED fixed_kernel(size_t m, size_t k, size_t n){
+    if (m != k || k != n) return NULL;
+    switch (n) {
+    case 8:   return batch_8;
+    case 16:  return batch_16;
+    case 32:  return batch_32;
+    case 64:  return batch_64;
+    case 128: return batch_128;
+    default:  return NULL;
+    }
+}
+
+static void batch_small(const uint* A, const uint* B, uint* C, size_t count,
+                        size_t m, size_t k, size_t n, int threads){
+    BATCH_FIXED fixed = fixed_kernel(m, k, n);
+
+    #pragma omp parallel for num_threads(threads > 1 ? threads : 1) if(threads > 1 && count > 1) schedule(static)
+    for(size_t b = 0; b < count; b++){
+        const uint* a = A + b*m*k;
+        const uint* bb = B + b*k*n;
+        uint* c = C + b*m*n;
+        if (fixed) fixed(a, bb, c);
+        else small_mm(a, bb, c, m, k, n);
+    }
+}
+
+static int batch_large(const uint* A, const uint* B, uint* C, size_t count,
+                       size_t m, size_t k, size_t n, const MATMUL_OPTS* opts, int threads){
+    MATMUL_OPTS one = opts ? *opts : (MATMUL_OPTS){0};
+    one.threads = 1;
+    int failed = 0;
+
+    #pragma omp parallel num_threads(threads > 1 ? threads : 1) if(threads > 1 && count > 1) reduction(|:failed)
+    {
+        MATMUL_PLAN plan;
+        int ready = !mm_plan_init(&plan, m, k, n, MATMUL_PACKED, &one, mm_arena());
+        failed |= !ready;
+
+        #pragma omp for schedule(dynamic)
+        for(size_t b = 0; b < count; b++){
+            if (ready) failed |= mm_plan_execute(&plan, A + b*m*k, B + b*k*n, C + b*m*n) != 0;
+        }
+        if (ready) mm_plan_fini(&plan);
+    }
+    return failed ? -1 : 0;
+}
+
+int matmul_batch(const uint32_t* A, const uint32_t* B, uint32_t* C, size_t count,
+                 size_t m, size_t k, size_t n, const MATMUL_OPTS* opts){
+    memset(mm_stats(), 0, sizeof(MATMUL_STATS));
+    if (!A || !B || !C) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!count || !m || !n) return 0;
+    if (!k) {
+        memset(C, 0, count*m*n*sizeof(uint));
+        return 0;
+    }
+
+    /* the products plan and run on the team's threads: all of it is compute here */
+    int threads = opts && opts->threads > 0 ? opts->threads : omp_get_max_threads();
+    double t = mm_now();
+    if (m <= BATCH_SMALL && k <= BATCH_SMALL && n <= BATCH_SMALL) {
+        batch_small(A, B, C, count, m, k, n, threads);
+        mm_phase(MATMUL_PHASE_COMPUTE, t);
+        return 0;
+    }
+    int failed = batch_large(A, B, C, count, m, k, n, opts, threads);
+    mm_phase(MATMUL_PHASE_COMPUTE, t);
+    if (failed) {
+        errno = ENOMEM;
+        return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,178 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "kernels.h"
+
+typedef struct MEM_TREE
+{
+    struct MEM_TREE* branch;
+    uint* MEM;
+    uint* sub_M[4];
+
+    size_t size;
+    size_t len;
+    size_t _2size;
+    size_t _4len;
+
+}MEM_TREE;
+
+
+
+static void MEM_free(MEM_TREE* tree, size_t size, size_t threshold);
+
+static int MEM_init(MEM_TREE* tree, size_t size, size_t threshold){
+    if (size < threshold || size%2){
+        return 0;
+    }
+
+    tree->size = size;
+    tree->_2size = size/2;
+    tree->len  = size*size;
+    tree->_4len  = size*size/4;
+
+    tree->branch = calloc(8, sizeof(MEM_TREE));
+    tree->MEM    = mm_alloc(tree->len);
+    if (!tree->branch || !tree->MEM){
+        free(tree->branch);
+        free(tree->MEM);
+        return -1;
+    }
+
+    tree->sub_M[0] = tree->MEM;
+    tree->sub_M[1] = tree->MEM + tree->_4len;
+    tree->sub_M[2] = tree->MEM + tree->_4len*2;
+    tree->sub_M[3] = tree->MEM + tree->_4len*3;
+
+
+    for (int i = 0; i < 8; i++){
+        if (MEM_init(tree->branch+i, size/2, threshold)){
+            while (i--) MEM_free(tree->branch+i, size/2, threshold);
+            free(tree->MEM);
+            free(tree->branch);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+
+static void MEM_free(MEM_TREE* tree, size_t size, size_t threshold){
+    if (size < threshold || size%2){
+        return;
+    }
+
+    free(tree->MEM);
+    
+    for (int i = 0; i < 8; i++){
+        MEM_free(tree->branch+i, size/2, threshold);
+    }
+
+    free(tree->branch);
+}
+
+
+static void dot(uint* A, uint* B, uint* D, size_t size, size_t total_size){
+    for(int i = 0; i < size; i++){
+        for(int j = 0; j < size; j++){
+            uint64_t sum = 0;
+            for(int k = 0; k < size; k++){
+                sum += (uint64_t)A[i*total_size+k]*B[j*total_size+k];
+            }
+            D[i*size+j] += (uint)sum;
+        }
+    }
+}
+
+
+static void add_to(uint* A, uint* B, size_t A_size, size_t B_size, size_t y, size_t x){
+    int index = B_size*y+x;
+    for(int i = 0; i < A_size; i++){
+        for(int j = 0; j < A_size; j++){
+             B[i*B_size+index+j] += A[i*A_size+j];
+        }
+    }
+}
+
+
+static void block_dot(uint* A, uint* B, uint* C, size_t size, size_t total_size, MEM_TREE* tree, size_t threshold){
+        size_t new_size = size / 2;
+        
+        if (size < threshold || size%2){
+            dot(A, B, C, size, total_size);
+        }else{
+            uint* A11 = A;
+            uint* A12 = A + new_size;
+            uint* A21 = A + new_size * total_size;
+            uint* A22 = A + new_size * total_size + new_size;
+
+            uint* B11 = B;
+            uint* B12 = B + new_size;
+            uint* B21 = B + new_size * total_size;
+            uint* B22 = B + new_size * total_size + new_size;
+
+            /* sub_M accumulate; clear them so a tree can be reused across calls */
+            memset(tree->MEM, 0, tree->len*sizeof(uint));
+
+            block_dot(A11, B11, tree->sub_M[0], new_size, total_size, tree->branch, threshold);
+            block_dot(A12, B12, tree->sub_M[0], new_size, total_size, tree->branch+1, threshold);
+            add_to(tree->sub_M[0], C, new_size, size, 0, 0);
+
+            block_dot(A11, B21, tree->sub_M[1], new_size, total_size, tree->branch+2, threshold);
+            block_dot(A12, B22, tree->sub_M[1], new_size, total_size, tree->branch+3, threshold);
+            add_to(tree->sub_M[1], C, new_size, size, 0, new_size);
+
+            block_dot(A21, B11, tree->sub_M[2], new_size, total_size, tree->branch+4, threshold);
+            block_dot(A22, B12, tree->sub_M[2], new_size, total_size, tree->branch+5, threshold);
+            add_to(tree->sub_M[2], C, new_size, size, new_size, 0);
+
+            block_dot(A21, B21, tree->sub_M[3], new_size, total_size, tree->branch+6, threshold);
+            block_dot(A22, B22, tree->sub_M[3], new_size, total_size, tree->branch+7, threshold);
+            add_to(tree->sub_M[3], C, new_size, size, new_size, new_size);
+
+            // free(MEM);
+    }
+
+}
+
+
+MEM_TREE* mm_block_tree(size_t size, size_t threshold){
+    MEM_TREE* tree = calloc(1, sizeof(MEM_TREE));
+    if (tree && MEM_init(tree, size, threshold)){
+        free(tree);
+        return NULL;
+    }
+    return tree;
+}
+
+static size_t MEM_bytes(size_t size, size_t threshold){
+    if (size < threshold || size%2){
+        return 0;
+    }
+    size_t bytes = 8*sizeof(MEM_TREE) + (size*size*sizeof(uint) + MM_ALIGN - 1) / MM_ALIGN * MM_ALIGN;
+    return bytes + 8*MEM_bytes(size/2, threshold);
+}
+
+size_t mm_block_bytes(size_t size, size_t threshold){
+    return sizeof(MEM_TREE) + MEM_bytes(size, threshold);
+}
+
+void mm_block_free(MEM_TREE* tree, size_t size, size_t threshold){
+    if (!tree) return;
+    MEM_free(tree, size, threshold);
+    free(tree);
+}
+
+void mm_block_run(const uint* A, const uint* F, uint* D, size_t size, size_t threshold, MEM_TREE* tree){
+    memset(D, 0, size*size*sizeof(uint));
+    block_dot((uint*)A, (uint*)F, D, size, size, tree, threshold);
+}
+
+int mm_block(const uint* A, const uint* F, uint* D, size_t size, size_t threshold){
+    MEM_TREE* tree = mm_block_tree(size, threshold);
+    if (!tree) return -1;
+
+    mm_block_run(A, F, D, size, threshold, tree);
+
+    mm_block_free(tree, size, threshold);
+    return 0;
+}
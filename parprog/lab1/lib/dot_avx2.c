@@ -0,0 +1,33 @@
+#include <immintrin.h>
+
+#include "kernels.h"
+
+void leaf_dot_avx2(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                   size_t m, size_t k, size_t n, const MM_PACKS* packs){
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            __m256i sum256 = _mm256_setzero_si256();
+            size_t p = 0;
+
+            for (; p + 7 < k; p += 8) {
+                __m256i a = _mm256_loadu_si256((const __m256i*)&A[i * lda + p]);
+                __m256i b = _mm256_loadu_si256((const __m256i*)&F[j * ldf + p]);
+                __m256i mul = _mm256_mullo_epi32(a, b);
+                sum256 = _mm256_add_epi32(sum256, mul);
+            }
+
+            __m128i low  = _mm256_castsi256_si128(sum256);
+            __m128i high = _mm256_extracti128_si256(sum256, 1);
+            __m128i sum128 = _mm_add_epi32(low, high);
+            sum128 = _mm_hadd_epi32(sum128, sum128);
+            sum128 = _mm_hadd_epi32(sum128, sum128);
+            uint64_t sum = (uint32_t)_mm_cvtsi128_si32(sum128);
+
+            for (; p < k; p++) {
+                sum += (uint64_t)A[i * lda + p] * F[j * ldf + p];
+            }
+
+            D[i * ldd + j] = (uint)sum;
+        }
+    }
+}
@@ -0,0 +1,93 @@
+#include <immintrin.h>
+
+#include "kernels.h"
+
+/*
+ * Widening dot-product kernels for the non-wrapping overflow modes.
+ * _mm256_mul_epu32 multiplies the even 32-bit lanes into full 64-bit
+ * products; the odd lanes are shifted down and multiplied the same way.
+ */
+
+#define SAT_LIMIT ((uint64_t)1 << 32)
+
+static uint64_t dot_u64(const uint* a, const uint* b, size_t k){
+    uint64_t sum = 0;
+    size_t p = 0;
+
+#ifdef __AVX2__
+    __m256i acc = _mm256_setzero_si256();
+    for (; p + 7 < k; p += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + p));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + p));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epu32(x, y));
+        acc = _mm256_add_epi64(acc, _mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32)));
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; p < k; p++) {
+        sum += (uint64_t)a[p] * b[p];
+    }
+    return sum;
+}
+
+/*
+ * Clamps the running sum at 2^32 after every product.  A product is at
+ * most 2^64 - 2^33 + 1, so adding it to a clamped sum never wraps.
+ */
+static uint dot_sat(const uint* a, const uint* b, size_t k){
+    uint64_t sum = 0;
+    size_t p = 0;
+
+#ifdef __AVX2__
+    const __m256i limit = _mm256_set1_epi64x(SAT_LIMIT);
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i acc = zero;
+    for (; p + 7 < k; p += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + p));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + p));
+
+        acc = _mm256_add_epi64(acc, _mm256_mul_epu32(x, y));
+        __m256i ok = _mm256_cmpeq_epi64(_mm256_srli_epi64(acc, 32), zero);
+        acc = _mm256_blendv_epi8(limit, acc, ok);
+
+        acc = _mm256_add_epi64(acc, _mm256_mul_epu32(_mm256_srli_epi64(x, 32), _mm256_srli_epi64(y, 32)));
+        ok = _mm256_cmpeq_epi64(_mm256_srli_epi64(acc, 32), zero);
+        acc = _mm256_blendv_epi8(limit, acc, ok);
+    }
+
+    uint64_t lanes[4];
+    _mm256_storeu_si256((__m256i*)lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+    if (sum > SAT_LIMIT) sum = SAT_LIMIT;
+#endif
+
+    for (; p < k; p++) {
+        sum += (uint64_t)a[p] * b[p];
+        if (sum > SAT_LIMIT) sum = SAT_LIMIT;
+    }
+    return sum >= SAT_LIMIT ? UINT32_MAX : (uint)sum;
+}
+
+int mm_dot_u64(const uint* A, const uint* F, uint64_t* D, size_t m, size_t k, size_t n, int threads){
+    #pragma omp parallel for num_threads(threads > 1 ? threads : 1) if(threads > 1) schedule(static)
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            D[i*n + j] = dot_u64(A + i*k, F + j*k, k);
+        }
+    }
+    return 0;
+}
+
+int mm_dot_sat(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n, int threads){
+    #pragma omp parallel for num_threads(threads > 1 ? threads : 1) if(threads > 1) schedule(static)
+    for (size_t i = 0; i < m; i++) {
+        for (size_t j = 0; j < n; j++) {
+            D[i*n + j] = dot_sat(A + i*k, F + j*k, k);
+        }
+    }
+    return 0;
+}
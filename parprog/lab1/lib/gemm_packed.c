@@ -0,0 +1,282 @@
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include <omp.h>
+
+#include "kernels.h"
+
+/*
+ * BLIS-style packed GEMM: D = A * B, with B given transposed (F = B^T).
+ *
+ *   A  - m x k, row stride lda
+ *   F  - n x k, row stride ldf
+ *   D  - m x n, row stride ldd
+ *
+ * A is packed into MR-row panels, F into NR-column panels (k-major), and an
+ * MR x NR AVX2 register tile is accumulated in 32-bit lanes (mod 2^32, same
+ * result as the uint64_t accumulation + truncation used by the other kernels).
+ *
+ * Either operand may be a signed sum of two equally strided views
+ * (MM_OPERAND); the sum is formed while packing, so Strassen leaves never
+ * materialise their operands.
+ *
+ * gemm_packed_B takes B in its native k x n layout instead: a packed panel
+ * row is NR consecutive elements of a row of B, so packing is a straight
+ * copy and no B^T is ever built.
+ *
+ * The packing buffers (one Fp, one Ap per thread) come from an MM_PACK the
+ * plan carved from its arena; a call larger than its MM_PACK was sized for
+ * shrinks KC / NC / MC to fit, and a call without one allocates its own.
+ */
+
+#define GP_MR 6
+#define GP_NR 16
+#define GP_MC 96
+#define GP_KC 256
+#define GP_NC 4096
+#define GP_ALIGN 32
+
+static MM_OPERAND gp_offset(MM_OPERAND op, size_t off){
+    op.X += off;
+    if (op.Y) op.Y += off;
+    return op;
+}
+
+static inline uint gp_get(const MM_OPERAND* op, size_t off){
+    if (!op->Y) return op->X[off];
+    return op->sign > 0 ? op->X[off] + op->Y[off] : op->X[off] - op->Y[off];
+}
+
+static void gp_pack_A(MM_OPERAND A, size_t lda, size_t mc, size_t kc, uint* Ap){
+    for(size_t i = 0; i < mc; i += GP_MR){
+        size_t mr = mc - i < GP_MR ? mc - i : GP_MR;
+        for(size_t p = 0; p < kc; p++){
+            for(size_t r = 0; r < mr; r++) Ap[p*GP_MR + r] = gp_get(&A, (i+r)*lda + p);
+            for(size_t r = mr; r < GP_MR; r++) Ap[p*GP_MR + r] = 0;
+        }
+        Ap += GP_MR*kc;
+    }
+}
+
+static void gp_pack_F(MM_OPERAND F, size_t ldf, size_t nc, size_t kc, uint* Fp){
+    for(size_t j = 0; j < nc; j += GP_NR){
+        size_t nr = nc - j < GP_NR ? nc - j : GP_NR;
+        for(size_t c = 0; c < nr; c++){
+            const uint* x = F.X + (j+c)*ldf;
+            const uint* y = F.Y ? F.Y + (j+c)*ldf : NULL;
+            if (!y)              for(size_t p = 0; p < kc; p++) Fp[p*GP_NR + c] = x[p];
+            else if (F.sign > 0) for(size_t p = 0; p < kc; p++) Fp[p*GP_NR + c] = x[p] + y[p];
+            else                 for(size_t p = 0; p < kc; p++) Fp[p*GP_NR + c] = x[p] - y[p];
+        }
+        for(size_t c = nr; c < GP_NR; c++){
+            for(size_t p = 0; p < kc; p++) Fp[p*GP_NR + c] = 0;
+        }
+        Fp += GP_NR*kc;
+    }
+}
+
+static void gp_pack_B(const uint* B, size_t ldb, size_t nc, size_t kc, uint* Fp){
+    for(size_t j = 0; j < nc; j += GP_NR){
+        size_t nr = nc - j < GP_NR ? nc - j : GP_NR;
+        for(size_t p = 0; p < kc; p++){
+            const uint* b = B + p*ldb + j;
+            uint* out = Fp + p*GP_NR;
+            if (nr == GP_NR) {
+                memcpy(out, b, GP_NR*sizeof(uint));
+                continue;
+            }
+            for(size_t c = 0; c < nr; c++) out[c] = b[c];
+            for(size_t c = nr; c < GP_NR; c++) out[c] = 0;
+        }
+        Fp += GP_NR*kc;
+    }
+}
+
+#define GP_ROW(r)                                                         \
+    a = _mm256_set1_epi32((int)Ap[r]);                                    \
+    c##r##0 = _mm256_add_epi32(c##r##0, _mm256_mullo_epi32(a, b0));       \
+    c##r##1 = _mm256_add_epi32(c##r##1, _mm256_mullo_epi32(a, b1));
+
+#define GP_STORE(r)                                                                   \
+    if (accumulate) {                                                                 \
+        c##r##0 = _mm256_add_epi32(c##r##0, _mm256_loadu_si256((__m256i*)(C + r*ldc)));     \
+        c##r##1 = _mm256_add_epi32(c##r##1, _mm256_loadu_si256((__m256i*)(C + r*ldc + 8)));  \
+    }                                                                                 \
+    _mm256_storeu_si256((__m256i*)(C + r*ldc), c##r##0);                              \
+    _mm256_storeu_si256((__m256i*)(C + r*ldc + 8), c##r##1);
+
+/* MR x NR register tile: C (+)= Ap * Fp over kc. */
+static void gp_kernel(size_t kc, const uint* Ap, const uint* Fp, uint* C, size_t ldc, int accumulate){
+    __m256i c00 = _mm256_setzero_si256(), c01 = _mm256_setzero_si256();
+    __m256i c10 = _mm256_setzero_si256(), c11 = _mm256_setzero_si256();
+    __m256i c20 = _mm256_setzero_si256(), c21 = _mm256_setzero_si256();
+    __m256i c30 = _mm256_setzero_si256(), c31 = _mm256_setzero_si256();
+    __m256i c40 = _mm256_setzero_si256(), c41 = _mm256_setzero_si256();
+    __m256i c50 = _mm256_setzero_si256(), c51 = _mm256_setzero_si256();
+    __m256i a, b0, b1;
+
+    for(size_t p = 0; p < kc; p++){
+        b0 = _mm256_load_si256((const __m256i*)Fp);
+        b1 = _mm256_load_si256((const __m256i*)(Fp + 8));
+        GP_ROW(0) GP_ROW(1) GP_ROW(2) GP_ROW(3) GP_ROW(4) GP_ROW(5)
+        Ap += GP_MR;
+        Fp += GP_NR;
+    }
+
+    GP_STORE(0) GP_STORE(1) GP_STORE(2) GP_STORE(3) GP_STORE(4) GP_STORE(5)
+}
+
+#undef GP_ROW
+#undef GP_STORE
+
+static void gp_macro_kernel(size_t mc, size_t nc, size_t kc, const uint* Ap, const uint* Fp,
+                            uint* D, size_t ldd, int accumulate){
+    uint tile[GP_MR*GP_NR] __attribute__((aligned(GP_ALIGN)));
+
+    for(size_t j = 0; j < nc; j += GP_NR){
+        size_t nr = nc - j < GP_NR ? nc - j : GP_NR;
+        for(size_t i = 0; i < mc; i += GP_MR){
+            size_t mr = mc - i < GP_MR ? mc - i : GP_MR;
+            uint* C = D + i*ldd + j;
+
+            if (mr == GP_MR && nr == GP_NR) {
+                gp_kernel(kc, Ap + i*kc, Fp + j*kc, C, ldd, accumulate);
+                continue;
+            }
+
+            gp_kernel(kc, Ap + i*kc, Fp + j*kc, tile, GP_NR, 0);
+            for(size_t r = 0; r < mr; r++){
+                for(size_t c = 0; c < nr; c++){
+                    if (accumulate) C[r*ldd + c] += tile[r*GP_NR + c];
+                    else            C[r*ldd + c]  = tile[r*GP_NR + c];
+                }
+            }
+        }
+    }
+}
+
+static size_t gp_round_up(size_t x, size_t to){
+    return (x + to - 1) / to * to;
+}
+
+static size_t gp_min(size_t a, size_t b){
+    return a < b ? a : b;
+}
+
+/* Buffer lengths for calls of up to m x k x n, padded so every Ap stays GP_ALIGN aligned. */
+static size_t gp_fp_len(size_t k, size_t n){
+    return gp_round_up(gp_round_up(gp_min(n, GP_NC), GP_NR) * gp_min(k, GP_KC), GP_ALIGN / sizeof(uint));
+}
+
+static size_t gp_ap_len(size_t m, size_t k){
+    return gp_round_up(gp_round_up(gp_min(m, GP_MC), GP_MR) * gp_min(k, GP_KC), GP_ALIGN / sizeof(uint));
+}
+
+size_t mm_pack_bytes(size_t m, size_t k, size_t n, int threads){
+    if (threads < 1) threads = 1;
+    return MM_ARENA_LEN((gp_fp_len(k, n) + threads * gp_ap_len(m, k)) * sizeof(uint));
+}
+
+void mm_pack_init(MM_PACK* pack, MM_ARENA* arena, size_t m, size_t k, size_t n, int threads){
+    if (threads < 1) threads = 1;
+    pack->fp_len = gp_fp_len(k, n);
+    pack->ap_len = gp_ap_len(m, k);
+    pack->threads = threads;
+    pack->Fp = mm_arena_push(arena, (pack->fp_len + threads * pack->ap_len) * sizeof(uint));
+    pack->Ap = pack->Fp + pack->fp_len;
+}
+
+/* native: F is B itself (k x n, row stride ldf, no sum) rather than B^T. */
+static int gp_gemm(MM_OPERAND A, size_t lda, MM_OPERAND F, size_t ldf, int native, uint* D, size_t ldd,
+                   size_t m, size_t k, size_t n, int threads, const MM_PACK* pack){
+    if (!m || !n) return 0;
+    if (!k) {
+        for(size_t i = 0; i < m; i++) memset(D + i*ldd, 0, n*sizeof(uint));
+        return 0;
+    }
+
+    int team = threads > 1 ? threads : 1;
+    MM_PACK own = {NULL, NULL, 0, 0, 0};
+    if (!pack || pack->threads < team) {
+        own.fp_len = gp_fp_len(k, n);
+        own.ap_len = gp_ap_len(m, k);
+        own.threads = team;
+        own.Fp = aligned_alloc(GP_ALIGN, (own.fp_len + team * own.ap_len) * sizeof(uint));
+        if (!own.Fp) return -1;
+        own.Ap = own.Fp + own.fp_len;
+        pack = &own;
+    }
+
+    /* KC, NC and MC, shrunk to what the buffers hold */
+    size_t kb = gp_min(gp_min(k, GP_KC), gp_min(pack->fp_len / GP_NR, pack->ap_len / GP_MR));
+    size_t nb = gp_min(GP_NC, pack->fp_len / kb / GP_NR * GP_NR);
+    size_t mb = gp_min(GP_MC, pack->ap_len / kb / GP_MR * GP_MR);
+    uint* Fp = pack->Fp;
+
+    for(size_t jc = 0; jc < n; jc += nb){
+        size_t nc = n - jc < nb ? n - jc : nb;
+
+        for(size_t pc = 0; pc < k; pc += kb){
+            size_t kc = k - pc < kb ? k - pc : kb;
+            if (native) gp_pack_B(F.X + pc*ldf + jc, ldf, nc, kc, Fp);
+            else        gp_pack_F(gp_offset(F, jc*ldf + pc), ldf, nc, kc, Fp);
+
+            #pragma omp parallel num_threads(team) if(threads > 1)
+            {
+                uint* Ap = pack->Ap + (size_t)omp_get_thread_num() * pack->ap_len;
+
+                #pragma omp for schedule(dynamic)
+                for(size_t ic = 0; ic < m; ic += mb){
+                    size_t mc = m - ic < mb ? m - ic : mb;
+                    gp_pack_A(gp_offset(A, ic*lda + pc), lda, mc, kc, Ap);
+                    gp_macro_kernel(mc, nc, kc, Ap, Fp, D + ic*ldd + jc, ldd, pc != 0);
+                }
+            }
+        }
+    }
+
+    free(own.Fp);
+    return 0;
+}
+
+int gemm_packed(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                size_t m, size_t k, size_t n, int threads, const MM_PACK* pack){
+    const MM_OPERAND a = {A, NULL, 0}, f = {F, NULL, 0};
+    return gp_gemm(a, lda, f, ldf, 0, D, ldd, m, k, n, threads, pack);
+}
+
+int gemm_packed_B(const uint* A, size_t lda, const uint* B, size_t ldb, uint* D, size_t ldd,
+                  size_t m, size_t k, size_t n, int threads, const MM_PACK* pack){
+    const MM_OPERAND a = {A, NULL, 0}, b = {B, NULL, 0};
+    return gp_gemm(a, lda, b, ldb, 1, D, ldd, m, k, n, threads, pack);
+}
+
+/* This thread's buffers; leaves contain no task scheduling points, so it stays theirs. */
+static const MM_PACK* leaf_pack(const MM_PACKS* packs){
+    if (!packs || !packs->pack) return NULL;
+    int id = packs->threads > 1 ? omp_get_thread_num() : 0;
+    return id < packs->threads ? &packs->pack[id] : NULL;
+}
+
+/* Single-threaded gemm_packed; falls back to leaf_dot if packing buffers can't be had. */
+void leaf_packed(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                 size_t m, size_t k, size_t n, const MM_PACKS* packs){
+    if (gemm_packed(A, lda, F, ldf, D, ldd, m, k, n, 0, leaf_pack(packs)))
+        leaf_dot(A, lda, F, ldf, D, ldd, m, k, n, NULL);
+}
+
+/* leaf_packed on operand sums; the fallback forms each sum on the fly. */
+void leaf_packed_sum(MM_OPERAND A, size_t lda, MM_OPERAND F, size_t ldf, uint* D, size_t ldd,
+                     size_t m, size_t k, size_t n, const MM_PACKS* packs){
+    if (!gp_gemm(A, lda, F, ldf, 0, D, ldd, m, k, n, 0, leaf_pack(packs))) return;
+
+    for(size_t i = 0; i < m; i++){
+        for(size_t j = 0; j < n; j++){
+            uint64_t sum = 0;
+            for(size_t p = 0; p < k; p++){
+                sum += (uint64_t)gp_get(&A, i*lda + p) * gp_get(&F, j*ldf + p);
+            }
+            D[i*ldd + j] = sum;
+        }
+    }
+}
@@ -0,0 +1,288 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+
+#include <inttypes.h>
+#include <stddef.h>
+
+#include "matmul.h"
+
+/*
+ * Internal kernel entry points.  A is m x k, B is k x n and D is m x n.
+ * Except for mm_slow, gemm_packed_B and the Morton engine, every kernel
+ * takes F = B^T (n x k); matmul() builds it.  All return 0 or -1 on
+ * allocation failure.
+ */
+
+typedef uint32_t uint;
+
+#define MM_ALIGN 64
+
+/* 64-byte aligned, zero-filled buffer of len elements. */
+uint* mm_alloc(size_t len);
+
+/* CLOCK_MONOTONIC seconds. */
+double mm_now(void);
+
+/*
+ * Bump arena for recursion workspace (see arena.c).  mm_arena_reserve
+ * makes room for `bytes` more (sum of MM_ARENA_LEN of every push) and
+ * pre-faults it, from a team of touch_threads when that is above 1;
+ * pushes are MM_ALIGN aligned and not zeroed.
+ */
+typedef struct MM_ARENA {
+    char* base;
+    size_t cap;
+    size_t top;
+    size_t touched;
+    MATMUL_HUGE huge;
+    int small_pages;        /* set by the caller: map without huge pages */
+} MM_ARENA;
+
+#define MM_ARENA_LEN(bytes) (((bytes) + MM_ALIGN - 1) / MM_ALIGN * MM_ALIGN)
+
+MM_ARENA* mm_arena(void);
+int mm_arena_reserve(MM_ARENA* a, size_t bytes, int touch_threads);
+void* mm_arena_push(MM_ARENA* a, size_t bytes);
+void mm_arena_pop(MM_ARENA* a, size_t mark);
+void mm_arena_release(MM_ARENA* a);
+
+/* Bytes the arena holds in RAM: the touched part in whole pages, all of a MAP_HUGETLB mapping. */
+size_t mm_arena_resident(const MM_ARENA* a);
+
+/*
+ * Packing buffers of one gemm_packed call: a B panel of fp_len elements
+ * and an A block of ap_len per thread, for up to `threads` threads.
+ * mm_pack_bytes / mm_pack_init size and carve them from an arena for
+ * calls of up to m x k x n; larger calls block to what fits.
+ */
+typedef struct MM_PACK {
+    uint* Fp;
+    uint* Ap;
+    size_t fp_len, ap_len;
+    int threads;
+} MM_PACK;
+
+size_t mm_pack_bytes(size_t m, size_t k, size_t n, int threads);
+void mm_pack_init(MM_PACK* pack, MM_ARENA* arena, size_t m, size_t k, size_t n, int threads);
+
+/*
+ * One single-thread MM_PACK for each of `threads` threads that run
+ * leaves at once; a leaf uses the one of omp_get_thread_num() (slot 0
+ * when threads is 1, so untasked runs may sit in any caller's team).
+ */
+typedef struct MM_PACKS {
+    MM_PACK* pack;
+    int threads;
+} MM_PACKS;
+
+/* Stats of the current call on this thread, reset by matmul_mkn. */
+MATMUL_STATS* mm_stats(void);
+
+/*
+ * Phase timer: adds the time since t0 to the phase and returns the current
+ * time, so back-to-back phases chain as t = mm_phase(PHASE, t).
+ */
+double mm_phase(MATMUL_PHASE phase, double t0);
+
+int mm_slow(const uint* A, const uint* B, uint* D, size_t m, size_t k, size_t n);
+int mm_transpose(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n);
+
+/* F = B^T, where B is k x n; cache blocked, AVX2 8 x 8 tiles, `threads` wide. */
+void mm_transpose_B(const uint* B, uint* F, size_t k, size_t n, int threads);
+/* mm_transpose_B for elements of 1, 2, 4 or 8 bytes; only 4 byte ones get the AVX2 tiles. */
+void mm_transpose_elems(const void* B, void* F, size_t k, size_t n, size_t elem, int threads);
+int mm_block(const uint* A, const uint* F, uint* D, size_t size, size_t threshold);
+
+/* Block recursion with its workspace tree built once (see MATMUL_PLAN). */
+typedef struct MEM_TREE MEM_TREE;
+MEM_TREE* mm_block_tree(size_t size, size_t threshold);
+size_t mm_block_bytes(size_t size, size_t threshold);  /* heap a tree takes, it is not in the arena */
+void mm_block_free(MEM_TREE* tree, size_t size, size_t threshold);
+void mm_block_run(const uint* A, const uint* F, uint* D, size_t size, size_t threshold, MEM_TREE* tree);
+
+/*
+ * Non-wrapping dot kernels (see MATMUL_OVERFLOW): exact 64-bit sums, or
+ * sums clamped to UINT32_MAX.  Rows are shared across `threads` threads.
+ */
+int mm_dot_u64(const uint* A, const uint* F, uint64_t* D, size_t m, size_t k, size_t n, int threads);
+int mm_dot_sat(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n, int threads);
+
+/* Knobs of one Strassen engine (strass, parallel, simd or winograd). */
+typedef struct MM_ENGINE_TUNING {
+    size_t cutoff;
+    size_t task_cutoff;
+    MATMUL_LEAF leaf;
+} MM_ENGINE_TUNING;
+
+typedef struct MM_TUNING {
+    size_t block_cutoff;
+    MM_ENGINE_TUNING strass;
+    MM_ENGINE_TUNING parallel;
+    MM_ENGINE_TUNING simd;
+    MM_ENGINE_TUNING winograd;
+} MM_TUNING;
+
+/* Tuning for a team of `threads` (0 = runtime default): its tuning file if one matches this host, else defaults. */
+void mm_tuning(int threads, MM_TUNING* out);
+
+/*
+ * Strassen engine behind strass / parallel / simd.  With tasks != 0 the
+ * seven products of large enough levels run as OpenMP tasks on a team of
+ * `threads` (0 = runtime default).  t->task_cutoff may be MATMUL_TASK_DEPTH.
+ * Untasked runs with profile != 0 fill in the level and combine times of
+ * MATMUL_STATS.
+ */
+int mm_strassen(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                const MM_ENGINE_TUNING* t, int tasks, int threads);
+
+/* t->task_cutoff with MATMUL_TASK_DEPTH resolved for this shape and team. */
+size_t mm_strassen_task_cutoff(const MM_ENGINE_TUNING* t, size_t m, size_t k, size_t n, int threads);
+
+/*
+ * mm_strassen in steps: arena bytes of the workspace tree and the leaf
+ * packing buffers, building both in an arena reserved for them, and
+ * running on them.
+ */
+typedef struct TREE_BF TREE_BF;
+size_t mm_strassen_bytes(size_t m, size_t k, size_t n, const MM_ENGINE_TUNING* t, int tasks, int threads);
+TREE_BF* mm_strassen_tree(MM_ARENA* arena, size_t m, size_t k, size_t n, const MM_ENGINE_TUNING* t, int tasks,
+                          int threads, MM_PACKS* packs);
+void mm_strassen_run(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                     const MM_ENGINE_TUNING* t, int tasks, int threads, int profile, TREE_BF* tree,
+                     const MM_PACKS* packs);
+
+/*
+ * Leaf kernels used under the Strassen recursion: D (m x n, stride ldd)
+ * = A (m x k, stride lda) * F^T (F is n x k, stride ldf).  Packing leaves
+ * take their buffers from `packs`, or allocate them when it is NULL.
+ */
+typedef void (*MM_LEAF)(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                        size_t m, size_t k, size_t n, const MM_PACKS* packs);
+
+void leaf_dot(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+              size_t m, size_t k, size_t n, const MM_PACKS* packs);
+void leaf_dot_avx2(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                   size_t m, size_t k, size_t n, const MM_PACKS* packs);
+void leaf_packed(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                 size_t m, size_t k, size_t n, const MM_PACKS* packs);
+
+/*
+ * Square leaves whose size is in the build's FIXED_LEAF_SIZES run a copy
+ * of the AVX2 kernel compiled for that size; others go to leaf_packed.
+ */
+void leaf_fixed(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                size_t m, size_t k, size_t n, const MM_PACKS* packs);
+
+MM_LEAF mm_leaf_fn(MATMUL_LEAF leaf);
+
+/*
+ * MM_PACKS for the leaves of a recursion on m x k x n that halves every
+ * side until one is at most `cutoff`, run by `threads` threads at once.
+ * Leaves that don't pack need none: 0 bytes and an empty MM_PACKS.
+ */
+size_t mm_leaf_packs_bytes(MATMUL_LEAF leaf, size_t m, size_t k, size_t n, size_t cutoff, int threads);
+void mm_leaf_packs_init(MM_PACKS* packs, MM_ARENA* arena, MATMUL_LEAF leaf,
+                        size_t m, size_t k, size_t n, size_t cutoff, int threads);
+
+/* One Strassen operand: X, or X + sign*Y when Y is set (same stride). */
+typedef struct MM_OPERAND {
+    const uint* X;
+    const uint* Y;
+    int sign;
+} MM_OPERAND;
+
+/*
+ * Leaf that forms its operand sums itself (while packing), so the last
+ * Strassen level needs no tempA / tempB.  NULL for leaves that can't.
+ */
+typedef void (*MM_LEAF_SUM)(MM_OPERAND A, size_t lda, MM_OPERAND F, size_t ldf, uint* D, size_t ldd,
+                            size_t m, size_t k, size_t n, const MM_PACKS* packs);
+
+void leaf_packed_sum(MM_OPERAND A, size_t lda, MM_OPERAND F, size_t ldf, uint* D, size_t ldd,
+                     size_t m, size_t k, size_t n, const MM_PACKS* packs);
+
+MM_LEAF_SUM mm_leaf_sum_fn(MATMUL_LEAF leaf);
+
+/*
+ * Odd-size fix-up after a Strassen level has filled the even leading
+ * part of D: adds the dropped inner index and computes the dropped row
+ * and column with `leaf`.
+ */
+void mm_strassen_peel(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                      size_t m, size_t k, size_t n, MM_LEAF leaf, const MM_PACKS* packs);
+
+/*
+ * Strassen-Winograd (7 products, 15 additions), sequential.  Products are
+ * written straight into the quadrants of D, so each level only needs two
+ * temporaries and the whole recursion one arena block.
+ */
+int mm_winograd(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                const MM_ENGINE_TUNING* t);
+size_t mm_winograd_bytes(size_t m, size_t k, size_t n, const MM_ENGINE_TUNING* t);
+void mm_winograd_run(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                     const MM_ENGINE_TUNING* t, uint* W, const MM_PACKS* packs);
+
+/*
+ * Strassen-Winograd on the Morton (Z-order) tiled layout, see morton.c.
+ * mm_morton_shape picks the tile and level count for a leaf cutoff; the
+ * operands are padded to (tile << levels)^2.  mm_morton_run packs A and
+ * row-major B (as B^T) into `work`, which holds mm_morton_bytes, recurses
+ * on contiguous quadrants and unpacks into C.
+ */
+void mm_morton_shape(size_t m, size_t k, size_t n, size_t cutoff, size_t* tile, int* levels);
+size_t mm_morton_bytes(size_t tile, int levels);
+void mm_morton_pack(const uint* src, size_t ld, size_t rows, size_t cols, int transpose,
+                    uint* dst, size_t tile, int levels, int threads);
+void mm_morton_unpack(const uint* src, size_t tile, int levels, uint* dst, size_t ld,
+                      size_t rows, size_t cols, int threads);
+void mm_morton_run(const uint* A, const uint* B, uint* C, size_t m, size_t k, size_t n,
+                   size_t tile, int levels, MM_LEAF leaf, const MM_PACKS* packs, int threads, uint* work);
+
+/*
+ * BLIS-style packed GEMM: D (m x n, stride ldd) = A (m x k, stride lda)
+ * times B, given as F = B^T (n x k, stride ldf).  With threads > 1 the MC
+ * loop is shared across an OpenMP team of that size.  Packing buffers come
+ * from `pack` when it has room for the team, else from the heap.
+ */
+int gemm_packed(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                size_t m, size_t k, size_t n, int threads, const MM_PACK* pack);
+
+/* gemm_packed with B in its own k x n layout (stride ldb), packed without a B^T. */
+int gemm_packed_B(const uint* A, size_t lda, const uint* B, size_t ldb, uint* D, size_t ldd,
+                  size_t m, size_t k, size_t n, int threads, const MM_PACK* pack);
+
+/*
+ * Everything a multiply of one shape needs besides its operands: resolved
+ * tuning, thread count, the B^T buffer and the engine workspace.  Arena
+ * memory comes from `arena` (the caller's thread-local arena for one-shot
+ * matmul_mkn calls, own_arena for public plans) above `mark`.
+ */
+struct MATMUL_PLAN {
+    size_t m, k, n;
+    MATMUL_ALGO algo;
+    int threads;
+    MM_ENGINE_TUNING tuning;
+    size_t block_cutoff;
+
+    MM_ARENA* arena;
+    MM_ARENA own_arena;
+    size_t mark;
+
+    uint* F;
+    TREE_BF* tree;
+    MM_PACKS packs;         /* leaf packing buffers */
+    MM_PACK pack;           /* packed: the whole multiply's */
+    uint* W;
+    MEM_TREE* block;
+    size_t heap_bytes;      /* workspace outside the arena (block tree) */
+    size_t tile;            /* Morton layout */
+    int levels;
+    int profile;
+};
+
+int mm_plan_init(MATMUL_PLAN* plan, size_t m, size_t k, size_t n, MATMUL_ALGO algo,
+                 const MATMUL_OPTS* opts, MM_ARENA* arena);
+int mm_plan_execute(MATMUL_PLAN* plan, const uint* A, const uint* B, uint* C);
+void mm_plan_fini(MATMUL_PLAN* plan);
+
+#endif
@@ -0,0 +1,96 @@
+#include <immintrin.h>
+
+#include "kernels.h"
+
+/*
+ * Size-specialised Strassen leaves.  fixed_leaf is one AVX2 kernel, 2 rows
+ * of A against 4 rows of F per register tile, with the (square) leaf size
+ * as a parameter; MM_FIXED_LEAF stamps out a copy per size in
+ * MM_FIXED_LEAF_SIZES with that size as a constant, so the trip counts are
+ * known and the compiler unrolls and schedules the inner loops.  The size
+ * list comes from the Makefile (FIXED_LEAF_SIZES); sizes must be multiples
+ * of 8.  Leaves of any other shape fall back to leaf_packed.
+ */
+
+#ifndef MM_FIXED_LEAF_SIZES
+#define MM_FIXED_LEAF_SIZES(X) X(64) X(128) X(256)
+#endif
+
+#ifdef __AVX2__
+
+/* Sums of a0..a3, one per 32-bit lane. */
+static inline __m128i hsum4(__m256i a0, __m256i a1, __m256i a2, __m256i a3){
+    __m256i s = _mm256_hadd_epi32(_mm256_hadd_epi32(a0, a1), _mm256_hadd_epi32(a2, a3));
+    return _mm_add_epi32(_mm256_castsi256_si128(s), _mm256_extracti128_si256(s, 1));
+}
+
+static inline __attribute__((always_inline))
+void fixed_leaf(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd, size_t N){
+    for(size_t i = 0; i < N; i += 2){
+        const uint* a0 = A + i*lda;
+        const uint* a1 = a0 + lda;
+        for(size_t j = 0; j < N; j += 4){
+            const uint* f0 = F + j*ldf;
+            const uint* f1 = f0 + ldf;
+            const uint* f2 = f1 + ldf;
+            const uint* f3 = f2 + ldf;
+
+            __m256i c00 = _mm256_setzero_si256(), c01 = c00, c02 = c00, c03 = c00;
+            __m256i c10 = c00, c11 = c00, c12 = c00, c13 = c00;
+            #pragma GCC unroll 4
+            for(size_t p = 0; p < N; p += 8){
+                __m256i x0 = _mm256_loadu_si256((const __m256i*)(a0 + p));
+                __m256i x1 = _mm256_loadu_si256((const __m256i*)(a1 + p));
+                __m256i y = _mm256_loadu_si256((const __m256i*)(f0 + p));
+                c00 = _mm256_add_epi32(c00, _mm256_mullo_epi32(x0, y));
+                c10 = _mm256_add_epi32(c10, _mm256_mullo_epi32(x1, y));
+                y = _mm256_loadu_si256((const __m256i*)(f1 + p));
+                c01 = _mm256_add_epi32(c01, _mm256_mullo_epi32(x0, y));
+                c11 = _mm256_add_epi32(c11, _mm256_mullo_epi32(x1, y));
+                y = _mm256_loadu_si256((const __m256i*)(f2 + p));
+                c02 = _mm256_add_epi32(c02, _mm256_mullo_epi32(x0, y));
+                c12 = _mm256_add_epi32(c12, _mm256_mullo_epi32(x1, y));
+                y = _mm256_loadu_si256((const __m256i*)(f3 + p));
+                c03 = _mm256_add_epi32(c03, _mm256_mullo_epi32(x0, y));
+                c13 = _mm256_add_epi32(c13, _mm256_mullo_epi32(x1, y));
+            }
+            _mm_storeu_si128((__m128i*)(D + i*ldd + j), hsum4(c00, c01, c02, c03));
+            _mm_storeu_si128((__m128i*)(D + (i+1)*ldd + j), hsum4(c10, c11, c12, c13));
+        }
+    }
+}
+
+#define MM_FIXED_LEAF(N)                                                                    \
+_Static_assert((N) % 8 == 0, "fixed leaf sizes must be multiples of 8");                    \
+static void leaf_fixed_##N(const uint* A, size_t lda, const uint* F, size_t ldf,            \
+                           uint* D, size_t ldd){                                            \
+    fixed_leaf(A, lda, F, ldf, D, ldd, N);                                                  \
+}
+
+MM_FIXED_LEAF_SIZES(MM_FIXED_LEAF)
+
+#undef MM_FIXED_LEAF
+
+#define MM_FIXED_CASE(N) case N: leaf_fixed_##N(A, lda, F, ldf, D, ldd); return;
+
+void leaf_fixed(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                size_t m, size_t k, size_t n, const MM_PACKS* packs){
+    if (m == k && k == n) {
+        switch (n) {
+        MM_FIXED_LEAF_SIZES(MM_FIXED_CASE)
+        default: break;
+        }
+    }
+    leaf_packed(A, lda, F, ldf, D, ldd, m, k, n, packs);
+}
+
+#undef MM_FIXED_CASE
+
+#else
+
+void leaf_fixed(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                size_t m, size_t k, size_t n, const MM_PACKS* packs){
+    leaf_packed(A, lda, F, ldf, D, ldd, m, k, n, packs);
+}
+
+#endif
@@ -0,0 +1,249 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "kernels.h"
+#include "matio.h"
+
+size_t mat_dtype_size(int dtype){
+    switch (dtype) {
+    case MAT_U32: return sizeof(uint32_t);
+    case MAT_U64: return sizeof(uint64_t);
+    case MAT_U8:  return sizeof(uint8_t);
+    case MAT_I16: return sizeof(int16_t);
+    case MAT_I32: return sizeof(int32_t);
+    case MAT_F32: return sizeof(float);
+    case MAT_F64: return sizeof(double);
+    default:      return 0;
+    }
+}
+
+static int mat_is_binary_path(const char* path){
+    size_t len = strlen(path);
+    size_t ext = strlen(MAT_BIN_EXT);
+    return len >= ext && !strcmp(path + len - ext, MAT_BIN_EXT);
+}
+
+/* Bytes of a binary file: header plus count matrices of rows x stride elements; -1 if that overflows. */
+static int mat_file_bytes(size_t header, size_t count, size_t rows, size_t stride, size_t elem, size_t* len){
+    size_t n;
+    if (__builtin_mul_overflow(count, rows, &n) || __builtin_mul_overflow(n, stride, &n)
+        || __builtin_mul_overflow(n, elem, &n) || __builtin_add_overflow(n, header, len)) {
+        return -1;
+    }
+    return 0;
+}
+
+/* Reads and checks the header of an open binary file, including that the data is all there. */
+static int mat_header(int fd, const char* path, MAT_HEADER* hdr){
+    struct stat st;
+    if (fstat(fd, &st)) {
+        perror("Failed to stat matrix file");
+        return -1;
+    }
+
+    if (pread(fd, hdr, sizeof(*hdr), 0) != sizeof(*hdr) || memcmp(hdr->magic, MAT_MAGIC, 4)) {
+        fprintf(stderr, "Missing or truncated header in %s\n", path);
+        return -1;
+    }
+    size_t elem = mat_dtype_size(hdr->dtype);
+    if (hdr->version != MAT_VERSION || !elem || hdr->stride < hdr->cols
+        || hdr->header_size < MAT_HEADER_SIZE || hdr->header_size % elem) {
+        fprintf(stderr, "Unsupported matrix header in %s (version %u, dtype %u)\n",
+                path, hdr->version, hdr->dtype);
+        return -1;
+    }
+
+    size_t count = hdr->count ? hdr->count : 1;
+    size_t need;
+    if (mat_file_bytes(hdr->header_size, count, hdr->rows, hdr->stride, elem, &need)) {
+        fprintf(stderr, "Matrix header in %s describes more data than fits in memory\n", path);
+        return -1;
+    }
+    if ((size_t)st.st_size < need) {
+        fprintf(stderr, "Matrix file %s is truncated\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+int mat_read_header(const char* path, MAT_HEADER* hdr){
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open matrix file");
+        return -1;
+    }
+    int status = mat_header(fd, path, hdr);
+    close(fd);
+    return status;
+}
+
+static int mat_load_binary(int fd, MAT_FILE* m){
+    MAT_HEADER hdr;
+    if (mat_header(fd, m->path, &hdr)) {
+        return -1;
+    }
+
+    size_t elem = mat_dtype_size(hdr.dtype);
+    size_t count = hdr.count ? hdr.count : 1;
+    size_t rows = count*hdr.rows;   /* mat_header checked the whole file size for overflow */
+    size_t need = hdr.header_size + rows*hdr.stride*elem;
+
+    m->map = mmap(NULL, need, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (m->map == MAP_FAILED) {
+        m->map = NULL;
+        perror("Failed to map matrix file");
+        return -1;
+    }
+    m->map_len = need;
+    m->rows = hdr.rows;
+    m->cols = hdr.cols;
+    m->count = count;
+    m->dtype = hdr.dtype;
+    madvise(m->map, need, MADV_WILLNEED);
+
+    char* src = (char*)m->map + hdr.header_size;
+    if (hdr.stride == hdr.cols) {
+        m->data = src;
+        return 0;
+    }
+
+    /* Padded rows: the kernels expect a dense matrix, so compact it. */
+    m->data = mm_alloc((rows*m->cols*elem + sizeof(uint) - 1) / sizeof(uint));
+    if (!m->data) {
+        fprintf(stderr, "Memory allocation failed for matrix %s\n", m->path);
+        return -1;
+    }
+    for(size_t i = 0; i < rows; i++){
+        memcpy((char*)m->data + i*m->cols*elem, src + i*hdr.stride*elem, m->cols*elem);
+    }
+    munmap(m->map, m->map_len);
+    m->map = NULL;
+    return 0;
+}
+
+int mat_load(const char* path, MAT_FILE* m){
+    memset(m, 0, sizeof(*m));
+    m->path = path;
+    m->dtype = MAT_U32;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        perror("Failed to open matrix file");
+        return -1;
+    }
+
+    char magic[4] = {0};
+    int status;
+    if (pread(fd, magic, sizeof(magic), 0) == sizeof(magic) && !memcmp(magic, MAT_MAGIC, 4)) {
+        m->binary = 1;
+        status = mat_load_binary(fd, m);
+    } else {
+        status = mat_load_text(fd, m);
+    }
+
+    close(fd);
+    return status;
+}
+
+int mat_create(const char* path, size_t rows, size_t cols, int dtype, MAT_FILE* m){
+    return mat_create_batch(path, 1, rows, cols, dtype, m);
+}
+
+int mat_create_batch(const char* path, size_t count, size_t rows, size_t cols, int dtype, MAT_FILE* m){
+    memset(m, 0, sizeof(*m));
+    m->path = path;
+    m->rows = rows;
+    m->cols = cols;
+    m->count = count;
+    m->dtype = dtype;
+    m->binary = mat_is_binary_path(path);
+
+    if (!m->binary && count != 1) {
+        fprintf(stderr, "Text format only holds one matrix; use a %s output for a batch of %zu\n",
+                MAT_BIN_EXT, count);
+        return -1;
+    }
+
+    size_t elem = mat_dtype_size(dtype);
+    if (!elem) {
+        fprintf(stderr, "Unsupported output dtype %d for %s\n", dtype, path);
+        return -1;
+    }
+    size_t len;
+    if (mat_file_bytes(MAT_HEADER_SIZE, count, rows, cols, elem, &len)) {
+        fprintf(stderr, "Output %s of %zu matrices %zux%zu is too large\n", path, count, rows, cols);
+        return -1;
+    }
+
+    if (!m->binary) {
+        m->data = mm_alloc((rows*cols*elem + sizeof(uint) - 1) / sizeof(uint));
+        if (!m->data) {
+            fprintf(stderr, "Memory allocation failed for matrix of size %zu\n", rows);
+            return -1;
+        }
+        return 0;
+    }
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        perror("Failed to open output file");
+        return -1;
+    }
+
+    if (ftruncate(fd, len)) {
+        perror("Failed to size output file");
+        close(fd);
+        return -1;
+    }
+
+    m->map = mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (m->map == MAP_FAILED) {
+        m->map = NULL;
+        perror("Failed to map output file");
+        return -1;
+    }
+    m->map_len = len;
+
+    MAT_HEADER* hdr = m->map;
+    memcpy(hdr->magic, MAT_MAGIC, 4);
+    hdr->version = MAT_VERSION;
+    hdr->dtype = dtype;
+    hdr->header_size = MAT_HEADER_SIZE;
+    hdr->alignment = MAT_ALIGN;
+    hdr->rows = rows;
+    hdr->cols = cols;
+    hdr->stride = cols;
+    hdr->count = count;
+
+    m->data = (char*)m->map + MAT_HEADER_SIZE;
+    return 0;
+}
+
+int mat_save(MAT_FILE* m){
+    if (m->binary) {
+        return msync(m->map, m->map_len, MS_ASYNC) ? (perror("Failed to write output file"), -1) : 0;
+    }
+
+    if (m->rows != m->cols) {
+        fprintf(stderr, "Text format only holds square matrices; use a %s output for %zux%zu\n",
+                MAT_BIN_EXT, m->rows, m->cols);
+        return -1;
+    }
+
+    return mat_save_text(m);
+}
+
+void mat_close(MAT_FILE* m){
+    if (m->map) {
+        munmap(m->map, m->map_len);
+    } else {
+        free(m->data);
+    }
+    memset(m, 0, sizeof(*m));
+}
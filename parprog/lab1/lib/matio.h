@@ -0,0 +1,97 @@
+#ifndef MATIO_H
+#define MATIO_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ * Matrix files come in two flavours:
+ *
+ *   text   - "<size>\n" followed by size*size whitespace separated values
+ *            (legacy format, always u32 on input);
+ *   binary - a 64 byte MAT_HEADER followed by rows*stride little-endian
+ *            elements, or by `count` such matrices back to back (a
+ *            batch).  Binary files are mapped with mmap and handed to
+ *            the kernels without a copy.
+ *
+ * The format of an input is detected from its magic, the format of an
+ * output from its extension (".bin" means binary).
+ */
+
+#define MAT_MAGIC "MATB"
+#define MAT_VERSION 1
+#define MAT_HEADER_SIZE 64
+#define MAT_ALIGN 64
+#define MAT_BIN_EXT ".bin"
+
+/* Same codes as MATMUL_DTYPE. */
+enum MAT_DTYPE {
+    MAT_U32 = 1,
+    MAT_U64 = 2,
+    MAT_U8  = 3,
+    MAT_I16 = 4,
+    MAT_I32 = 5,
+    MAT_F32 = 6,
+    MAT_F64 = 7,
+};
+
+typedef struct MAT_HEADER {
+    char     magic[4];
+    uint16_t version;
+    uint16_t dtype;
+    uint32_t header_size;   /* byte offset of the first element */
+    uint32_t alignment;     /* alignment of the data offset, bytes */
+    uint64_t rows;
+    uint64_t cols;
+    uint64_t stride;        /* elements between consecutive rows */
+    uint64_t count;         /* matrices in the file, 0 and 1 both mean one */
+    uint8_t  reserved[16];
+} MAT_HEADER;
+
+_Static_assert(sizeof(MAT_HEADER) == MAT_HEADER_SIZE, "MAT_HEADER must be 64 bytes");
+
+typedef struct MAT_FILE {
+    void*       data;
+    size_t      rows;
+    size_t      cols;
+    size_t      count;      /* matrices in a batch file, 1 otherwise */
+    int         dtype;      /* enum MAT_DTYPE */
+
+    const char* path;
+    int         binary;
+    void*       map;        /* mmap base for binary files, NULL otherwise */
+    size_t      map_len;
+} MAT_FILE;
+
+/* Bytes per element of a MAT_DTYPE, 0 for unknown types. */
+size_t mat_dtype_size(int dtype);
+
+/* Opens an existing matrix, binary (any dtype) or text (u32).  Returns 0 on success. */
+int mat_load(const char* path, MAT_FILE* m);
+
+/*
+ * Reads and validates the header of a binary file without mapping its
+ * data, for callers that stream it (matmul_ooc).  Returns 0 on success.
+ */
+int mat_read_header(const char* path, MAT_HEADER* hdr);
+
+/*
+ * Creates a zero-filled rows x cols output of the given dtype.  Binary
+ * outputs are mapped straight onto the file; text outputs are buffered
+ * until mat_save().
+ */
+int mat_create(const char* path, size_t rows, size_t cols, int dtype, MAT_FILE* m);
+
+/* mat_create for a batch of `count` matrices; batches are binary only. */
+int mat_create_batch(const char* path, size_t count, size_t rows, size_t cols, int dtype, MAT_FILE* m);
+
+/* Flushes an output created by mat_create(). */
+int mat_save(MAT_FILE* m);
+
+void mat_close(MAT_FILE* m);
+
+/* The text format, parsed and formatted in parallel (matio_text.c). */
+int mat_load_text(int fd, MAT_FILE* m);
+int mat_save_text(MAT_FILE* m);
+
+#endif
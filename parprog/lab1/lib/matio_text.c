@@ -0,0 +1,350 @@
+#include <errno.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <immintrin.h>
+#include <omp.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+
+#include "kernels.h"
+#include "matio.h"
+
+/*
+ * The legacy text format, in parallel.  The loader maps the file, cuts the
+ * values into one chunk per thread on whitespace, counts the values of
+ * every chunk and, after a prefix sum, parses each chunk straight into its
+ * slice of the matrix.  Token boundaries come from 32 byte AVX2 digit
+ * masks and tokens of up to 8 digits are converted with SWAR multiplies.
+ *
+ * The writer formats one slice per thread into a private buffer and hands
+ * all of them to a single writev().
+ */
+
+#define TEXT_CHUNK_MIN (1 << 16)    /* bytes per thread; smaller files use fewer threads */
+
+static inline int is_digit(char c){
+    return (unsigned char)(c - '0') < 10;
+}
+
+static inline int is_space(char c){
+    return c == ' ' || (unsigned char)(c - '\t') < 5;     /* \t \n \v \f \r */
+}
+
+typedef struct TEXT_CHUNK {
+    uint32_t*   out;        /* NULL while counting */
+    size_t      first;      /* index of the chunk's first value */
+    size_t      cap;        /* values past this index are ignored */
+    size_t      n;          /* values seen */
+    const char* bad;        /* first unexpected character or out of range value */
+} TEXT_CHUNK;
+
+/* Stores the token [end - len, end).  `base` is the start of the mapping, below which the SWAR load must not reach. */
+static inline void emit(TEXT_CHUNK* c, const char* base, const char* end, size_t len){
+    size_t i = c->first + c->n++;
+    if (!c->out || i >= c->cap) return;
+
+    uint64_t v;
+    if (len <= 8 && end - base >= 8) {
+        /* the token is in the high bytes; the bytes before it are masked to leading zeros */
+        memcpy(&v, end - 8, 8);
+        v &= ~0ULL << 8*(8 - len) & 0x0F0F0F0F0F0F0F0FULL;
+        v = (v * 2561) >> 8;
+        v = ((v & 0x00FF00FF00FF00FFULL) * 6553601) >> 16;
+        v = ((v & 0x0000FFFF0000FFFFULL) * 42949672960001ULL) >> 32;
+    } else {
+        v = 0;
+        for(const char* p = end - len; p < end && v <= UINT32_MAX; p++){
+            v = v*10 + (*p - '0');
+        }
+    }
+    if (v > UINT32_MAX) {
+        if (!c->bad) c->bad = end - len;
+        return;
+    }
+    c->out[i] = (uint32_t)v;
+}
+
+static void scan(TEXT_CHUNK* c, const char* base, const char* p, const char* end){
+    size_t run = 0;         /* digits right before p */
+#ifdef __AVX2__
+    const __m256i zero = _mm256_set1_epi8('0'), nine = _mm256_set1_epi8(9);
+    const __m256i tab = _mm256_set1_epi8('\t'), four = _mm256_set1_epi8(4), space = _mm256_set1_epi8(' ');
+    for(; end - p >= 32; p += 32){
+        __m256i x = _mm256_loadu_si256((const __m256i*)p);
+        __m256i d = _mm256_sub_epi8(x, zero);
+        __m256i w = _mm256_sub_epi8(x, tab);
+        uint32_t digits = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_min_epu8(d, nine), d));
+        uint32_t spaces = _mm256_movemask_epi8(_mm256_or_si256(_mm256_cmpeq_epi8(x, space),
+                                                               _mm256_cmpeq_epi8(_mm256_min_epu8(w, four), w)));
+        if (~(digits | spaces)) {
+            c->bad = p + __builtin_ctz(~(digits | spaces));
+            return;
+        }
+
+        /* a token ends at every non-digit that follows a digit */
+        uint32_t ends = ~digits & (digits << 1 | (run > 0));
+        while (ends) {
+            int i = __builtin_ctz(ends);
+            uint32_t gaps = i ? ~digits << (32 - i) : 0;
+            emit(c, base, p + i, gaps ? (size_t)__builtin_clz(gaps) : i + run);
+            ends &= ends - 1;
+        }
+        run = digits == UINT32_MAX ? run + 32 : (size_t)__builtin_clz(~digits);
+    }
+#endif
+    for(; p < end; p++){
+        if (is_digit(*p)) {
+            run++;
+            continue;
+        }
+        if (!is_space(*p)) {
+            c->bad = p;
+            return;
+        }
+        if (run) emit(c, base, p, run);
+        run = 0;
+    }
+    if (run) emit(c, base, end, run);
+}
+
+/* Start of chunk t of T in [lo, hi), moved forward off any token it lands in. */
+static const char* cut(const char* lo, const char* hi, int t, int T){
+    if (t >= T) return hi;
+    const char* p = lo + (size_t)(hi - lo) * t / T;
+    while (p < hi && is_digit(*p)) p++;
+    return p;
+}
+
+int mat_load_text(int fd, MAT_FILE* m){
+    struct stat st;
+    if (fstat(fd, &st)) {
+        perror("Failed to stat matrix file");
+        return -1;
+    }
+    size_t bytes = st.st_size;
+    const char* map = bytes ? mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0) : NULL;
+    if (map == MAP_FAILED) {
+        perror("Failed to map matrix file");
+        return -1;
+    }
+    madvise((void*)map, bytes, MADV_WILLNEED);
+
+    const char* p = map;
+    const char* end = map + bytes;
+    size_t size = 0;
+    while (p < end && is_space(*p)) p++;
+    while (p < end && is_digit(*p) && size <= INT_MAX) size = size*10 + (*p++ - '0');
+    if (!size || size > INT_MAX || (p < end && !is_space(*p))) {
+        fprintf(stderr, "Failed to read size from %s\n", m->path);
+        if (map) munmap((void*)map, bytes);
+        return -1;
+    }
+
+    size_t len = size*size;
+    m->rows = m->cols = size;
+    m->count = 1;
+    m->data = mm_alloc(len);
+    int threads = omp_get_max_threads();
+    if ((size_t)threads > bytes / TEXT_CHUNK_MIN + 1) threads = bytes / TEXT_CHUNK_MIN + 1;
+    TEXT_CHUNK* chunks = calloc(threads, sizeof(TEXT_CHUNK));
+    if (!m->data || !chunks) {
+        fprintf(stderr, "Memory allocation failed for matrix of size %zu\n", size);
+        free(chunks);
+        free(m->data);
+        m->data = NULL;
+        munmap((void*)map, bytes);
+        return -1;
+    }
+
+    #pragma omp parallel num_threads(threads)
+    {
+        int t = omp_get_thread_num(), team = omp_get_num_threads();
+        const char* lo = cut(p, end, t, team);
+        const char* hi = cut(p, end, t + 1, team);
+        TEXT_CHUNK* c = &chunks[t];
+        scan(c, map, lo, hi);
+        #pragma omp barrier
+
+        int ok = 1;
+        size_t first = 0;
+        for(int i = 0; i < team; i++){
+            ok &= !chunks[i].bad;
+            if (i < t) first += chunks[i].n;
+        }
+        #pragma omp barrier
+        if (ok) {
+            *c = (TEXT_CHUNK){.out = m->data, .first = first, .cap = len};
+            scan(c, map, lo, hi);
+        }
+    }
+
+    size_t total = 0;
+    const char* bad = NULL;
+    for(int t = 0; t < threads; t++){
+        total += chunks[t].n;
+        if (!bad) bad = chunks[t].bad;
+    }
+    free(chunks);
+
+    int status = 0;
+    if (bad && is_digit(*bad)) {
+        fprintf(stderr, "Value out of range at byte %zu of %s\n", (size_t)(bad - map), m->path);
+        status = -1;
+    } else if (bad) {
+        fprintf(stderr, "Unexpected character '%c' at byte %zu of %s\n", *bad, (size_t)(bad - map), m->path);
+        status = -1;
+    } else if (total < len) {
+        fprintf(stderr, "Failed to read matrix data at index %zu of %s\n", total, m->path);
+        status = -1;
+    }
+    if (status) {
+        free(m->data);
+        m->data = NULL;
+    }
+    munmap((void*)map, bytes);
+    return status;
+}
+
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+    "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+    "8081828384858687888990919293949596979899";
+
+static inline char* put_u64(char* out, uint64_t v){
+    char tmp[20];
+    char* p = tmp + sizeof(tmp);
+    while (v >= 100) {
+        p -= 2;
+        memcpy(p, DIGIT_PAIRS + 2*(v % 100), 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        p -= 2;
+        memcpy(p, DIGIT_PAIRS + 2*v, 2);
+    } else {
+        *--p = '0' + v;
+    }
+    size_t n = tmp + sizeof(tmp) - p;
+    memcpy(out, p, n);
+    return out + n;
+}
+
+static inline char* put_i64(char* out, int64_t v){
+    if (v < 0) {
+        *out++ = '-';
+        return put_u64(out, -(uint64_t)v);
+    }
+    return put_u64(out, v);
+}
+
+/* Upper bound on the characters of one formatted element, separator and a trailing NUL included. */
+static size_t text_width(int dtype){
+    switch (dtype) {
+    case MAT_U64: return 22;
+    case MAT_U8:  return 5;
+    case MAT_I16: return 8;
+    case MAT_I32: return 13;
+    case MAT_F32: return 24;
+    case MAT_F64: return 32;
+    default:      return 12;
+    }
+}
+
+static size_t text_format(const MAT_FILE* m, size_t lo, size_t hi, char* out){
+    char* p = out;
+    for(size_t i = lo; i < hi; i++){
+        switch (m->dtype) {
+        case MAT_U64: p = put_u64(p, ((uint64_t*)m->data)[i]); break;
+        case MAT_U8:  p = put_u64(p, ((uint8_t*)m->data)[i]); break;
+        case MAT_I16: p = put_i64(p, ((int16_t*)m->data)[i]); break;
+        case MAT_I32: p = put_i64(p, ((int32_t*)m->data)[i]); break;
+        case MAT_F32: p += sprintf(p, "%.9g", ((float*)m->data)[i]); break;
+        case MAT_F64: p += sprintf(p, "%.17g", ((double*)m->data)[i]); break;
+        default:      p = put_u64(p, ((uint32_t*)m->data)[i]); break;
+        }
+        *p++ = ' ';
+    }
+    return p - out;
+}
+
+/* writev() until everything is out; advances `iov` in place. */
+static int write_all(int fd, struct iovec* iov, int n){
+    while (n) {
+        ssize_t w = writev(fd, iov, n);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        while (n && (size_t)w >= iov->iov_len) {
+            w -= iov->iov_len;
+            iov++;
+            n--;
+        }
+        if (n) {
+            iov->iov_base = (char*)iov->iov_base + w;
+            iov->iov_len -= w;
+        }
+    }
+    return 0;
+}
+
+int mat_save_text(MAT_FILE* m){
+    size_t len = m->rows*m->cols;
+    size_t width = text_width(m->dtype);
+    int threads = omp_get_max_threads();
+    if ((size_t)threads > len*width / TEXT_CHUNK_MIN + 1) threads = len*width / TEXT_CHUNK_MIN + 1;
+    if (threads > MATMUL_STATS_THREADS) threads = MATMUL_STATS_THREADS;     /* stays under IOV_MAX */
+
+    char head[32];
+    char** bufs = calloc(threads, sizeof(char*));
+    struct iovec* iov = calloc(threads + 1, sizeof(struct iovec));
+    if (!bufs || !iov) {
+        fprintf(stderr, "Memory allocation failed for output %s\n", m->path);
+        free(bufs);
+        free(iov);
+        return -1;
+    }
+    iov[0].iov_base = head;
+    iov[0].iov_len = snprintf(head, sizeof(head), "%zu\n", m->rows);
+
+    int failed = 0;
+    #pragma omp parallel num_threads(threads) reduction(|:failed)
+    {
+        int t = omp_get_thread_num(), team = omp_get_num_threads();
+        size_t lo = len*t / team, hi = len*(t + 1) / team;
+        bufs[t] = malloc((hi - lo)*width + 1);
+        if (bufs[t]) {
+            iov[t + 1].iov_base = bufs[t];
+            iov[t + 1].iov_len = text_format(m, lo, hi, bufs[t]);
+        } else {
+            failed = 1;
+        }
+    }
+
+    int status = -1;
+    if (failed) {
+        fprintf(stderr, "Memory allocation failed for output %s\n", m->path);
+    } else {
+        int fd = open(m->path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            perror("Failed to open output file");
+        } else if (write_all(fd, iov, threads + 1) | close(fd)) {
+            perror("Failed to write output file");
+        } else {
+            status = 0;
+        }
+    }
+
+    for(int t = 0; t < threads; t++){
+        free(bufs[t]);
+    }
+    free(bufs);
+    free(iov);
+    return status;
+}
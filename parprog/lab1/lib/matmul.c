@@ -0,0 +1,138 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "kernels.h"
+#include "matmul.h"
+
+static const struct {
+    const char* name;
+    const char* label;
+} ALGOS[MATMUL_ALGO_COUNT] = {
+    [MATMUL_SLOW]      = {"slow",      "SLOW"},
+    [MATMUL_TRANSPOSE] = {"transpose", "TRANSPOSE"},
+    [MATMUL_BLOCK]     = {"block",     "BLOCK_TRANSPOSE"},
+    [MATMUL_STRASSEN]  = {"strass",    "STRASSEN_TRANSPOSE"},
+    [MATMUL_PARALLEL]  = {"parallel",  "PARALLEL_STRASSEN_TRANSPOSE"},
+    [MATMUL_SIMD]      = {"simd",      "SIMD_PARALLEL_STRASSEN_TRANSPOSE"},
+    [MATMUL_PACKED]    = {"packed",    "GEMM_PACKED"},
+    [MATMUL_WINOGRAD]  = {"winograd",  "WINOGRAD_TRANSPOSE"},
+    [MATMUL_MORTON]    = {"morton",    "WINOGRAD_MORTON"},
+};
+
+const char* matmul_algo_name(MATMUL_ALGO algo){
+    return algo < MATMUL_ALGO_COUNT ? ALGOS[algo].name : NULL;
+}
+
+const char* matmul_algo_label(MATMUL_ALGO algo){
+    return algo < MATMUL_ALGO_COUNT ? ALGOS[algo].label : NULL;
+}
+
+MATMUL_ALGO matmul_algo_from_name(const char* name){
+    for (int i = 0; i < MATMUL_ALGO_COUNT; i++) {
+        if (!strcmp(name, ALGOS[i].name)) return i;
+    }
+    return MATMUL_ALGO_COUNT;
+}
+
+static const char* const PHASES[MATMUL_PHASE_COUNT] = {
+    [MATMUL_PHASE_SETUP]     = "setup",
+    [MATMUL_PHASE_TRANSPOSE] = "transpose",
+    [MATMUL_PHASE_COMPUTE]   = "compute",
+    [MATMUL_PHASE_COMBINE]   = "combine",
+};
+
+const char* matmul_phase_name(MATMUL_PHASE phase){
+    return phase < MATMUL_PHASE_COUNT ? PHASES[phase] : NULL;
+}
+
+static const struct {
+    const char* name;
+    const char* label;
+} OVERFLOW_MODES[MATMUL_OVERFLOW_COUNT] = {
+    [MATMUL_WRAP]     = {"wrap",     NULL},
+    [MATMUL_EXACT64]  = {"exact64",  "DOT_EXACT64"},
+    [MATMUL_SATURATE] = {"saturate", "DOT_SATURATE"},
+};
+
+const char* matmul_overflow_name(MATMUL_OVERFLOW mode){
+    return mode < MATMUL_OVERFLOW_COUNT ? OVERFLOW_MODES[mode].name : NULL;
+}
+
+const char* matmul_overflow_label(MATMUL_OVERFLOW mode){
+    return mode < MATMUL_OVERFLOW_COUNT ? OVERFLOW_MODES[mode].label : NULL;
+}
+
+MATMUL_OVERFLOW matmul_overflow_from_name(const char* name){
+    for (int i = 0; i < MATMUL_OVERFLOW_COUNT; i++) {
+        if (!strcmp(name, OVERFLOW_MODES[i].name)) return i;
+    }
+    return MATMUL_OVERFLOW_COUNT;
+}
+
+uint* mm_alloc(size_t len){
+    size_t bytes = (len*sizeof(uint) + MM_ALIGN - 1) / MM_ALIGN * MM_ALIGN;
+    uint* p = aligned_alloc(MM_ALIGN, bytes ? bytes : MM_ALIGN);
+    if (p) memset(p, 0, bytes);
+    return p;
+}
+
+/* F = B^T (n x k); sets errno and returns NULL when out of memory. */
+static uint* transpose_B(const uint* B, size_t k, size_t n, int threads){
+    uint* F = mm_alloc(n*k);
+    if (!F) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    mm_transpose_B(B, F, k, n, threads);
+    return F;
+}
+
+int matmul_mkn(const uint32_t* A, const uint32_t* B, uint32_t* C, size_t m, size_t k, size_t n,
+               MATMUL_ALGO algo, const MATMUL_OPTS* opts){
+    memset(mm_stats(), 0, sizeof(MATMUL_STATS));
+    if (!A || !B || !C) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    MATMUL_PLAN plan;
+    if (mm_plan_init(&plan, m, k, n, algo, opts, mm_arena())) return -1;
+
+    int status = mm_plan_execute(&plan, A, B, C);
+
+    mm_plan_fini(&plan);
+    return status;
+}
+
+int matmul(const uint32_t* A, const uint32_t* B, uint32_t* C, size_t n,
+           MATMUL_ALGO algo, const MATMUL_OPTS* opts){
+    return matmul_mkn(A, B, C, n, n, n, algo, opts);
+}
+
+int matmul_overflow(const uint32_t* A, const uint32_t* B, void* C, size_t m, size_t k, size_t n,
+                    MATMUL_ALGO algo, MATMUL_OVERFLOW mode, const MATMUL_OPTS* opts){
+    if (mode == MATMUL_WRAP) return matmul_mkn(A, B, C, m, k, n, algo, opts);
+    memset(mm_stats(), 0, sizeof(MATMUL_STATS));
+    if (!A || !B || !C || mode >= MATMUL_OVERFLOW_COUNT) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!m || !n) return 0;
+
+    int threads = opts && opts->threads > 0 ? opts->threads : omp_get_max_threads();
+
+    double t = mm_now();
+    uint* F = transpose_B(B, k, n, threads);
+    if (!F) return -1;
+    t = mm_phase(MATMUL_PHASE_TRANSPOSE, t);
+
+    if (mode == MATMUL_EXACT64) mm_dot_u64(A, F, C, m, k, n, threads);
+    else                        mm_dot_sat(A, F, C, m, k, n, threads);
+    mm_phase(MATMUL_PHASE_COMPUTE, t);
+
+    free(F);
+    return 0;
+}
@@ -0,0 +1,336 @@
+#ifndef MATMUL_H
+#define MATMUL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+
+/*
+ * libmatmul: every lab1 kernel behind one entry point.
+ *
+ *   C = A * B   (n x n, row-major, uint32_t, products taken mod 2^32)
+ *
+ * The call owns any scratch it needs (the transposed copy of B, Strassen
+ * workspace trees); A and B are only read and C is fully overwritten.
+ */
+
+typedef enum MATMUL_ALGO {
+    MATMUL_SLOW,
+    MATMUL_TRANSPOSE,
+    MATMUL_BLOCK,
+    MATMUL_STRASSEN,
+    MATMUL_PARALLEL,
+    MATMUL_SIMD,
+    MATMUL_PACKED,
+    MATMUL_WINOGRAD,
+    MATMUL_MORTON,          /* Winograd on a Z-order tiled copy of the operands */
+    MATMUL_ALGO_COUNT
+} MATMUL_ALGO;
+
+/* Leaf kernel under the Strassen recursion. */
+typedef enum MATMUL_LEAF {
+    MATMUL_LEAF_DEFAULT,
+    MATMUL_LEAF_DOT,
+    MATMUL_LEAF_AVX2,
+    MATMUL_LEAF_PACKED,
+    MATMUL_LEAF_FIXED,      /* size-specialised kernels, packed for other sizes */
+    MATMUL_LEAF_COUNT
+} MATMUL_LEAF;
+
+/*
+ * Zero / MATMUL_LEAF_DEFAULT fields take their value from the tuning file
+ * (see matmul_autotune), or from the built-in defaults without one.
+ */
+typedef struct MATMUL_OPTS {
+    int threads;            /* OpenMP threads for the parallel kernels, 0 = runtime default */
+    size_t cutoff;          /* Strassen / block recursion cutoff */
+    size_t task_cutoff;     /* smallest level that spawns tasks (parallel, simd) */
+    MATMUL_LEAF leaf;       /* Strassen leaf kernel */
+    int numa;               /* first-touch new workspace from the whole team */
+    int profile;            /* time strass levels and combines too (see MATMUL_STATS) */
+} MATMUL_OPTS;
+
+/*
+ * task_cutoff value that picks the task levels from the thread count and
+ * the recursion depth instead of from a fixed size.
+ */
+#define MATMUL_TASK_DEPTH ((size_t)-2)
+
+/* Returns 0 on success, -1 with errno set (EINVAL, ENOMEM) on failure. */
+int matmul(const uint32_t* A, const uint32_t* B, uint32_t* C, size_t n,
+           MATMUL_ALGO algo, const MATMUL_OPTS* opts);
+
+/*
+ * Rectangular form: A is m x k, B is k x n, C is m x n.  Every algorithm
+ * except MATMUL_BLOCK accepts arbitrary shapes.
+ */
+int matmul_mkn(const uint32_t* A, const uint32_t* B, uint32_t* C, size_t m, size_t k, size_t n,
+               MATMUL_ALGO algo, const MATMUL_OPTS* opts);
+
+/*
+ * What happens when a sum of products leaves the uint32_t range:
+ *
+ *   MATMUL_WRAP     - reduce mod 2^32 (matmul / matmul_mkn)
+ *   MATMUL_EXACT64  - uint64_t output, exact while the sum is below 2^64
+ *   MATMUL_SATURATE - uint32_t output clamped to UINT32_MAX
+ */
+typedef enum MATMUL_OVERFLOW {
+    MATMUL_WRAP,
+    MATMUL_EXACT64,
+    MATMUL_SATURATE,
+    MATMUL_OVERFLOW_COUNT
+} MATMUL_OVERFLOW;
+
+/*
+ * matmul_mkn with explicit overflow semantics.  C is uint64_t* for
+ * MATMUL_EXACT64 and uint32_t* otherwise.  The Strassen-family algorithms
+ * rely on wraparound, so EXACT64 and SATURATE always run the widening
+ * AVX2 dot kernel and `algo` only matters for MATMUL_WRAP.
+ */
+int matmul_overflow(const uint32_t* A, const uint32_t* B, void* C, size_t m, size_t k, size_t n,
+                    MATMUL_ALGO algo, MATMUL_OVERFLOW mode, const MATMUL_OPTS* opts);
+
+/* "wrap", "exact64", "saturate"; MATMUL_OVERFLOW_COUNT for unknown names. */
+const char* matmul_overflow_name(MATMUL_OVERFLOW mode);
+MATMUL_OVERFLOW matmul_overflow_from_name(const char* name);
+
+/* Log label of a non-wrapping mode ("DOT_EXACT64", ...), NULL for MATMUL_WRAP. */
+const char* matmul_overflow_label(MATMUL_OVERFLOW mode);
+
+/*
+ * Element types.  The values are the dtype codes of the binary matrix
+ * header (matio.h), so a loaded file's dtype can be passed straight in.
+ */
+typedef enum MATMUL_DTYPE {
+    MATMUL_U32 = 1,
+    MATMUL_U64 = 2,     /* output only (MATMUL_EXACT64) */
+    MATMUL_U8  = 3,
+    MATMUL_I16 = 4,
+    MATMUL_I32 = 5,
+    MATMUL_F32 = 6,
+    MATMUL_F64 = 7,
+    MATMUL_DTYPE_MAX
+} MATMUL_DTYPE;
+
+/*
+ * C = A * B for inputs of type `dtype`; C has type matmul_dtype_out(dtype):
+ * u8 -> u32, i16 -> i32, i32 -> i32, f32 -> f32, f64 -> f64.  Integer sums
+ * wrap mod 2^32.  MATMUL_U32 goes through matmul_mkn with `algo`; the
+ * other types use an AVX2 dot kernel and ignore it.
+ */
+int matmul_typed(const void* A, const void* B, void* C, size_t m, size_t k, size_t n,
+                 MATMUL_DTYPE dtype, MATMUL_ALGO algo, const MATMUL_OPTS* opts);
+
+/* Output type for inputs of `dtype`, 0 for unknown types. */
+MATMUL_DTYPE matmul_dtype_out(MATMUL_DTYPE dtype);
+
+/* "u8", "i16", ...; matmul_dtype_from_name returns 0 for unknown names. */
+const char* matmul_dtype_name(MATMUL_DTYPE dtype);
+MATMUL_DTYPE matmul_dtype_from_name(const char* name);
+
+/* Log label of a non-u32 dtype ("DOT_U8_U32", ...), NULL for MATMUL_U32. */
+const char* matmul_dtype_label(MATMUL_DTYPE dtype);
+
+/*
+ * `count` independent products C[i] = A[i] * B[i], each operand stored back
+ * to back (A is count x m x k, ...), u32 wrapping.  The batch is shared
+ * across the threads and every product runs sequentially, which is what
+ * small sizes want: one team for the whole batch, no per-product setup.
+ */
+int matmul_batch(const uint32_t* A, const uint32_t* B, uint32_t* C, size_t count,
+                 size_t m, size_t k, size_t n, const MATMUL_OPTS* opts);
+
+/*
+ * Out-of-core C = A * B for u32 binary matrix files (matio.h, one matrix
+ * each) that need not fit in memory.  The inputs are mapped and streamed
+ * in tile panels, the next panel read while the current one is computed
+ * with `algo`, and C is written to the binary file C_path tile by tile.
+ * Resident memory (panel buffers plus all of `algo`'s workspace, its
+ * packing buffers and heap included, with the workspace arena rounded up
+ * to its 2 MiB pages when it has huge pages) stays within `budget` bytes;
+ * ENOMEM if even the smallest tiles don't fit.
+ */
+int matmul_ooc(const char* A_path, const char* B_path, const char* C_path, size_t budget,
+               MATMUL_ALGO algo, const MATMUL_OPTS* opts);
+
+/*
+ * Workspace accounting of the calling thread's last matmul* call.  Strassen
+ * and Winograd workspace lives in a per-thread arena that is kept between
+ * calls: alloc_seconds is the time spent mapping it (0 when it was reused),
+ * touch_seconds the time spent pre-faulting new pages.
+ */
+typedef enum MATMUL_HUGE {
+    MATMUL_HUGE_NONE,
+    MATMUL_HUGE_THP,        /* transparent huge pages requested with madvise */
+    MATMUL_HUGE_HUGETLB     /* explicit MAP_HUGETLB pages */
+} MATMUL_HUGE;
+
+#define MATMUL_STATS_THREADS 256
+#define MATMUL_STATS_LEVELS 32
+
+/*
+ * Where a call spends its time.  setup is planning and workspace (it
+ * includes alloc_seconds and touch_seconds), transpose is building B^T or
+ * packing into and out of the Morton layout, and with MATMUL_OPTS.profile
+ * the strass operand sums, combines and peels move from compute to
+ * combine.
+ */
+typedef enum MATMUL_PHASE {
+    MATMUL_PHASE_SETUP,
+    MATMUL_PHASE_TRANSPOSE,
+    MATMUL_PHASE_COMPUTE,
+    MATMUL_PHASE_COMBINE,
+    MATMUL_PHASE_COUNT
+} MATMUL_PHASE;
+
+/* "setup", "transpose", "compute", "combine". */
+const char* matmul_phase_name(MATMUL_PHASE phase);
+
+/*
+ * Tasked Strassen runs (parallel, simd) also fill in the team size, the
+ * wall time of the parallel region and, per thread, the time spent
+ * computing; team_seconds - busy_seconds[i] is thread i's idle and
+ * scheduling time.  team_threads is 0 after untasked calls.
+ *
+ * Profiled strass runs record, per recursion depth, the time spent in all
+ * nodes of that depth including their subtrees (level_seconds[0] is the
+ * whole recursion); levels is the number of depths reached.
+ *
+ * matmul_ooc reports the time its loader spent reading panels and the
+ * time the compute waited for them (io_wait_seconds near 0 means the reads
+ * were hidden), and its total resident buffers as workspace_bytes.
+ */
+typedef struct MATMUL_STATS {
+    double alloc_seconds;
+    double touch_seconds;
+    size_t workspace_bytes;
+    MATMUL_HUGE huge_pages;
+
+    int team_threads;
+    double team_seconds;
+    double busy_seconds[MATMUL_STATS_THREADS];
+
+    double io_seconds;
+    double io_wait_seconds;
+
+    double phase_seconds[MATMUL_PHASE_COUNT];
+    int levels;
+    double level_seconds[MATMUL_STATS_LEVELS];
+} MATMUL_STATS;
+
+void matmul_get_stats(MATMUL_STATS* out);
+
+/*
+ * Hardware counters (perf_event_open) of the calling thread and the rest of
+ * a `threads` OpenMP team (0 = runtime default), for telling compute-bound
+ * from memory-bound kernels.  Counts are user space only, run from start
+ * to stop and are scaled when the PMU multiplexes; events the machine
+ * cannot count read MATMUL_PERF_NA.  matmul_perf_open returns NULL with
+ * errno set when no event can be opened at all (no PMU, or
+ * kernel.perf_event_paranoid above 2).  The events follow PERF_EVENTS in
+ * common/perf_events.h, the list lab2 and lab3 count too.
+ */
+typedef enum MATMUL_PERF_EVENT {
+    MATMUL_PERF_CYCLES,
+    MATMUL_PERF_INSTRUCTIONS,
+    MATMUL_PERF_L1D_MISSES,     /* L1 data cache read misses */
+    MATMUL_PERF_LLC_MISSES,
+    MATMUL_PERF_DTLB_MISSES,    /* data TLB read misses */
+    MATMUL_PERF_BRANCH_MISSES,
+    MATMUL_PERF_EVENT_COUNT
+} MATMUL_PERF_EVENT;
+
+#define MATMUL_PERF_NA UINT64_MAX
+
+typedef struct MATMUL_PERF_COUNTS {
+    int threads;
+    uint64_t total[MATMUL_PERF_EVENT_COUNT];
+    uint64_t thread[MATMUL_STATS_THREADS][MATMUL_PERF_EVENT_COUNT];
+} MATMUL_PERF_COUNTS;
+
+typedef struct MATMUL_PERF MATMUL_PERF;
+
+MATMUL_PERF* matmul_perf_open(int threads);
+void matmul_perf_start(MATMUL_PERF* perf);
+void matmul_perf_stop(MATMUL_PERF* perf, MATMUL_PERF_COUNTS* out);
+void matmul_perf_close(MATMUL_PERF* perf);
+
+/* "cycles", "instructions", "l1d_misses", ...; used as log and CSV keys. */
+const char* matmul_perf_event_name(MATMUL_PERF_EVENT event);
+
+/* Unmaps the calling thread's workspace arena; the next call maps it again. */
+void matmul_release_workspace(void);
+
+/*
+ * NUMA first touch: anonymous buffers whose pages are touched by a team of
+ * `threads` in contiguous chunks (the kernels' static row split), zeroed
+ * or copied from src.  NULL with errno set on failure.
+ */
+void* matmul_numa_alloc(size_t bytes, int threads);
+void* matmul_numa_dup(const void* src, size_t bytes, int threads);
+void matmul_numa_free(void* p, size_t bytes);
+
+typedef struct MATMUL_NUMA_BUF {
+    const char* name;
+    const void* addr;
+    size_t len;
+} MATMUL_NUMA_BUF;
+
+/*
+ * Prints the node of every thread of a `threads` team and, from
+ * move_pages(2), the per-node placement of each buffer and of the calling
+ * thread's workspace.  Each buffer is cut into the team's chunks as
+ * matmul_numa_alloc does; "remote" is the share of chunk pages that sit
+ * off the node of the chunk's thread.
+ */
+int matmul_numa_report(FILE* out, const MATMUL_NUMA_BUF* bufs, int count, int threads);
+
+/*
+ * Plans: everything that depends only on the shape (tuning, thread team,
+ * workspace, the B^T buffer) is set up once by matmul_plan_create, so
+ * matmul_plan_execute only transposes B (when the algorithm reads B^T) and
+ * computes.  A plan runs one execute at a time.  create returns NULL with
+ * errno set on failure.
+ */
+typedef struct MATMUL_PLAN MATMUL_PLAN;
+
+MATMUL_PLAN* matmul_plan_create(size_t n, MATMUL_ALGO algo, const MATMUL_OPTS* opts);
+MATMUL_PLAN* matmul_plan_create_mkn(size_t m, size_t k, size_t n, MATMUL_ALGO algo, const MATMUL_OPTS* opts);
+int matmul_plan_execute(MATMUL_PLAN* plan, const uint32_t* A, const uint32_t* B, uint32_t* C);
+void matmul_plan_destroy(MATMUL_PLAN* plan);
+
+/* Short name used by --algo= ("slow", "strass", ...). */
+const char* matmul_algo_name(MATMUL_ALGO algo);
+
+/* Label written to the timing log ("SLOW", "STRASSEN_TRANSPOSE", ...). */
+const char* matmul_algo_label(MATMUL_ALGO algo);
+
+/* Returns MATMUL_ALGO_COUNT for unknown names. */
+MATMUL_ALGO matmul_algo_from_name(const char* name);
+
+/* "dot", "avx2", "packed", "fixed"; MATMUL_LEAF_COUNT for unknown names. */
+const char* matmul_leaf_name(MATMUL_LEAF leaf);
+MATMUL_LEAF matmul_leaf_from_name(const char* name);
+
+/*
+ * Tuning file for a team of `threads` (0 = runtime default): $MATMUL_TUNE_FILE,
+ * else $XDG_CACHE_HOME/matmul/tune-<host>-t<threads>.conf (~/.cache when
+ * XDG_CACHE_HOME is unset), so every thread count keeps its own tuning.
+ * A file is read the first time its thread count is used and ignored when
+ * it was written for a different host or thread count (which makes a
+ * $MATMUL_TUNE_FILE hold one thread count).
+ */
+const char* matmul_tune_path(int threads);
+
+/* 1 if a tuning file for this host and thread count is in effect. */
+int matmul_tuned(int threads);
+
+/*
+ * Sweeps leaf kernels, Strassen / block cutoffs and task cutoffs on n x n
+ * problems (0 = 1024) with `threads` threads (0 = runtime default), writes
+ * the winners to matmul_tune_path(threads) and makes them the defaults
+ * of that thread count.  Progress goes to `report` when it is not NULL.
+ */
+int matmul_autotune(size_t n, int threads, FILE* report);
+
+#endif
@@ -0,0 +1,160 @@
+#include "kernels.h"
+
+/*
+ * Morton (Z-order) tiled layout for the recursive kernels.  A matrix is
+ * zero-padded to P x P, P = T * 2^levels, and cut into T x T row-major
+ * tiles stored in Z order, so every quadrant at every level of the
+ * recursion is one contiguous block: quadrant q of a block of len
+ * elements starts at q * len / 4 (0 = top left, 1 = top right,
+ * 2 = bottom left, 3 = bottom right).  Operand sums become flat loops and
+ * each leaf streams three contiguous T x T tiles.
+ *
+ * The recursion is the Strassen-Winograd schedule of winograd.c on those
+ * blocks.  B is packed as F = B^T straight from row-major B, so Bij is the
+ * F quadrant ji.  The tile size is the smallest multiple of MORTON_ALIGN
+ * that reaches the leaf cutoff after halving, which keeps padding small.
+ */
+
+#define MORTON_ALIGN 16
+
+static size_t max3(size_t a, size_t b, size_t c){
+    size_t r = a > b ? a : b;
+    return r > c ? r : c;
+}
+
+void mm_morton_shape(size_t m, size_t k, size_t n, size_t cutoff, size_t* tile, int* levels){
+    size_t side = max3(m, k, n);
+    if (cutoff < MORTON_ALIGN) cutoff = MORTON_ALIGN;
+    int l = 0;
+    while ((side + ((size_t)1 << l) - 1) >> l > cutoff) l++;
+    size_t t = (side + ((size_t)1 << l) - 1) >> l;
+    *tile = (t + MORTON_ALIGN - 1) / MORTON_ALIGN * MORTON_ALIGN;
+    *levels = l;
+}
+
+static size_t zorder(size_t ti, size_t tj){
+    size_t z = 0;
+    for (int b = 0; (ti | tj) >> b; b++) {
+        z |= ((ti >> b) & 1) << (2*b + 1);
+        z |= ((tj >> b) & 1) << (2*b);
+    }
+    return z;
+}
+
+void mm_morton_pack(const uint* src, size_t ld, size_t rows, size_t cols, int transpose,
+                    uint* dst, size_t tile, int levels, int threads){
+    size_t grid = (size_t)1 << levels;
+
+    #pragma omp parallel for collapse(2) num_threads(threads > 1 ? threads : 1) if(threads > 1) schedule(static)
+    for(size_t ti = 0; ti < grid; ti++){
+        for(size_t tj = 0; tj < grid; tj++){
+            uint* t = dst + zorder(ti, tj) * tile * tile;
+            size_t r0 = ti * tile, c0 = tj * tile;
+            for(size_t r = 0; r < tile; r++){
+                uint* out = t + r * tile;
+                size_t row = r0 + r;
+                size_t c = 0;
+                if (row < rows) {
+                    size_t end = cols > c0 ? (cols - c0 < tile ? cols - c0 : tile) : 0;
+                    if (transpose) for(; c < end; c++) out[c] = src[(c0 + c) * ld + row];
+                    else           for(; c < end; c++) out[c] = src[row * ld + c0 + c];
+                }
+                for(; c < tile; c++) out[c] = 0;
+            }
+        }
+    }
+}
+
+void mm_morton_unpack(const uint* src, size_t tile, int levels, uint* dst, size_t ld,
+                      size_t rows, size_t cols, int threads){
+    size_t grid = (size_t)1 << levels;
+
+    #pragma omp parallel for collapse(2) num_threads(threads > 1 ? threads : 1) if(threads > 1) schedule(static)
+    for(size_t ti = 0; ti < grid; ti++){
+        for(size_t tj = 0; tj < grid; tj++){
+            size_t r0 = ti * tile, c0 = tj * tile;
+            if (r0 >= rows || c0 >= cols) continue;
+            const uint* t = src + zorder(ti, tj) * tile * tile;
+            size_t nr = rows - r0 < tile ? rows - r0 : tile;
+            size_t nc = cols - c0 < tile ? cols - c0 : tile;
+            for(size_t r = 0; r < nr; r++){
+                const uint* in = t + r * tile;
+                uint* out = dst + (r0 + r) * ld + c0;
+                for(size_t c = 0; c < nc; c++) out[c] = in[c];
+            }
+        }
+    }
+}
+
+/* Z = X + sign*Y over len contiguous elements; Z may alias X or Y. */
+static void add(const uint* X, const uint* Y, uint* Z, size_t len, int sign){
+    if (sign > 0) for(size_t i = 0; i < len; i++) Z[i] = X[i] + Y[i];
+    else          for(size_t i = 0; i < len; i++) Z[i] = X[i] - Y[i];
+}
+
+static void morton(const uint* A, const uint* F, uint* D, size_t len, size_t tile, uint* W, MM_LEAF leaf,
+                   const MM_PACKS* packs){
+    if (len == tile * tile) {
+        leaf(A, tile, F, tile, D, tile, tile, tile, tile, packs);
+        return;
+    }
+
+    size_t q = len / 4;
+    const uint *A11 = A, *A12 = A + q, *A21 = A + 2*q, *A22 = A + 3*q;
+    const uint *B11 = F, *B21 = F + q, *B12 = F + 2*q, *B22 = F + 3*q;
+    uint *C11 = D, *C12 = D + q, *C21 = D + 2*q, *C22 = D + 3*q;
+    uint* X = W;
+    uint* Y = W + q;
+    uint* next = W + 2*q;
+
+    add(A11, A21, X, q, -1);                            /* S3 */
+    add(B22, B12, Y, q, -1);                            /* T3 */
+    morton(X, Y, C21, q, tile, next, leaf, packs);      /* P7 */
+    add(A21, A22, X, q, 1);                             /* S1 */
+    add(B12, B11, Y, q, -1);                            /* T1 */
+    morton(X, Y, C22, q, tile, next, leaf, packs);      /* P5 */
+    add(X, A11, X, q, -1);                              /* S2 */
+    add(B22, Y, Y, q, -1);                              /* T2 */
+    morton(X, Y, C12, q, tile, next, leaf, packs);      /* P6 */
+    add(A12, X, X, q, -1);                              /* S4 */
+    morton(X, B22, C11, q, tile, next, leaf, packs);    /* P3 */
+    morton(A11, B11, X, q, tile, next, leaf, packs);    /* P1 */
+    add(X, C12, C12, q, 1);                             /* U2 = P1 + P6 */
+    add(C12, C21, C21, q, 1);                           /* U3 = U2 + P7 */
+    add(C12, C22, C12, q, 1);                           /* U4 = U2 + P5 */
+    add(C21, C22, C22, q, 1);                           /* U7 = U3 + P5 */
+    add(C12, C11, C12, q, 1);                           /* U5 = U4 + P3 */
+    add(Y, B21, Y, q, -1);                              /* T4 */
+    morton(A22, Y, C11, q, tile, next, leaf, packs);    /* P4 */
+    add(C21, C11, C21, q, -1);                          /* U6 = U3 - P4 */
+    morton(A12, B21, C11, q, tile, next, leaf, packs);  /* P2 */
+    add(X, C11, C11, q, 1);                             /* U1 = P1 + P2 */
+}
+
+size_t mm_morton_bytes(size_t tile, int levels){
+    size_t side = tile << levels;
+    size_t words = 3 * side * side;             /* A, F and D in Morton order */
+    for (int l = 1; l <= levels; l++) {
+        size_t s = side >> l;
+        words += 2 * s * s;                     /* X and Y of each level */
+    }
+    return words * sizeof(uint);
+}
+
+void mm_morton_run(const uint* A, const uint* B, uint* C, size_t m, size_t k, size_t n,
+                   size_t tile, int levels, MM_LEAF leaf, const MM_PACKS* packs, int threads, uint* work){
+    size_t side = tile << levels;
+    size_t len = side * side;
+    uint* Am = work;
+    uint* Fm = Am + len;
+    uint* Dm = Fm + len;
+
+    double t = mm_now();
+    mm_morton_pack(A, k, m, k, 0, Am, tile, levels, threads);
+    mm_morton_pack(B, n, n, k, 1, Fm, tile, levels, threads);
+    t = mm_phase(MATMUL_PHASE_TRANSPOSE, t);
+    morton(Am, Fm, Dm, len, tile, Dm + len, leaf, packs);
+    t = mm_phase(MATMUL_PHASE_COMPUTE, t);
+    mm_morton_unpack(Dm, tile, levels, C, n, m, n, threads);
+    mm_phase(MATMUL_PHASE_TRANSPOSE, t);
+}
@@ -0,0 +1,196 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <omp.h>
+
+#include "kernels.h"
+
+/*
+ * NUMA helpers for --numa.  Buffers are fresh anonymous mappings whose
+ * pages are first touched by a team split into contiguous, page aligned
+ * chunks, the same static row split the row-parallel kernels use, so each
+ * chunk lands on the node of the thread that works on it.  The report
+ * asks move_pages(2) where each page of those chunks is and compares it
+ * with the node of the chunk's thread.
+ */
+
+#define PAGE 4096
+#define MAX_NODES 64
+#define QUERY_PAGES 1024
+
+typedef void (*CHUNK_FN)(char* dst, const char* src, size_t len);
+
+static void chunk_zero(char* dst, const char* src, size_t len){
+    (void)src;
+    memset(dst, 0, len);
+}
+
+static void chunk_copy(char* dst, const char* src, size_t len){
+    memcpy(dst, src, len);
+}
+
+/* Chunk of thread t of nt: page aligned, so no page is shared by two threads. */
+static size_t chunk_len(size_t bytes, int nt){
+    return ((bytes + nt - 1) / nt + PAGE - 1) & ~(size_t)(PAGE - 1);
+}
+
+static void split(char* dst, const char* src, size_t bytes, int threads, CHUNK_FN fn){
+    #pragma omp parallel num_threads(threads > 1 ? threads : 1)
+    {
+        int t = omp_get_thread_num(), nt = omp_get_num_threads();
+        size_t chunk = chunk_len(bytes, nt);
+        size_t lo = chunk * t, hi = lo + chunk < bytes ? lo + chunk : bytes;
+        if (lo < hi) fn(dst + lo, src ? src + lo : NULL, hi - lo);
+    }
+}
+
+static size_t map_len(size_t bytes){
+    return (bytes + PAGE - 1) & ~(size_t)(PAGE - 1);
+}
+
+static void* map(size_t bytes){
+    char* p = mmap(NULL, map_len(bytes), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (p == MAP_FAILED) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    return p;
+}
+
+void* matmul_numa_alloc(size_t bytes, int threads){
+    char* p = map(bytes);
+    if (p) split(p, NULL, bytes, threads, chunk_zero);
+    return p;
+}
+
+void* matmul_numa_dup(const void* src, size_t bytes, int threads){
+    char* p = map(bytes);
+    if (p) split(p, src, bytes, threads, chunk_copy);
+    return p;
+}
+
+void matmul_numa_free(void* p, size_t bytes){
+    if (p) munmap(p, map_len(bytes));
+}
+
+static int current_node(void){
+    unsigned cpu = 0, node = 0;
+    if (syscall(SYS_getcpu, &cpu, &node, NULL)) return 0;
+    return node < MAX_NODES ? (int)node : 0;
+}
+
+typedef struct PLACEMENT {
+    double bytes[MAX_NODES];
+    double owned;           /* bytes in chunks whose thread's node is known */
+    double remote;          /* of those, bytes off that node */
+} PLACEMENT;
+
+/*
+ * Adds the pages of [addr, addr + len) to p, by the node move_pages(2)
+ * reports for each; pages off `node` (-1: unknown) are remote.  Pages
+ * never touched have no node and count nowhere.
+ */
+static int query(const char* addr, size_t len, int node, PLACEMENT* p){
+    void* pages[QUERY_PAGES];
+    int status[QUERY_PAGES];
+
+    for(size_t off = 0; off < len; off += (size_t)QUERY_PAGES * PAGE){
+        unsigned long count = 0;
+        while (count < QUERY_PAGES && off + count * PAGE < len) {
+            pages[count] = (void*)(addr + off + count * PAGE);
+            count++;
+        }
+        if (syscall(SYS_move_pages, 0, count, pages, NULL, status, 0)) return -1;
+
+        for(unsigned long i = 0; i < count; i++){
+            if (status[i] < 0 || status[i] >= MAX_NODES) continue;
+            p->bytes[status[i]] += PAGE;
+            if (node < 0) continue;
+            p->owned += PAGE;
+            if (status[i] != node) p->remote += PAGE;
+        }
+    }
+    return 0;
+}
+
+/* Placement of a buffer split over `team` threads as split() does, chunk t owned by nodes[t]. */
+static int placement(const void* addr, size_t len, int team, const int* nodes, int recorded, PLACEMENT* p){
+    memset(p, 0, sizeof(*p));
+    const char* base = (const char*)((uintptr_t)addr & ~(uintptr_t)(PAGE - 1));
+    len += (const char*)addr - base;
+
+    size_t chunk = chunk_len(len, team);
+    for(int t = 0; t < team; t++){
+        size_t lo = chunk * t, hi = lo + chunk < len ? lo + chunk : len;
+        if (lo < hi && query(base + lo, hi - lo, t < recorded ? nodes[t] : -1, p)) return -1;
+    }
+    return 0;
+}
+
+static void add_placement(PLACEMENT* sum, const PLACEMENT* p){
+    for (int i = 0; i < MAX_NODES; i++) sum->bytes[i] += p->bytes[i];
+    sum->owned += p->owned;
+    sum->remote += p->remote;
+}
+
+static void print_buffer(FILE* out, const char* name, const PLACEMENT* p){
+    double total = 0;
+    for (int i = 0; i < MAX_NODES; i++) total += p->bytes[i];
+
+    fprintf(out, "[numa] %-10s %9.1f MiB", name, total / (1 << 20));
+    for (int i = 0; i < MAX_NODES; i++) {
+        if (p->bytes[i]) fprintf(out, "  N%d %5.1f%%", i, 100 * p->bytes[i] / total);
+    }
+    fprintf(out, "  remote %5.1f%%\n", p->owned ? 100 * p->remote / p->owned : 0);
+}
+
+int matmul_numa_report(FILE* out, const MATMUL_NUMA_BUF* bufs, int count, int threads){
+    if (threads <= 0) threads = omp_get_max_threads();
+
+    /* Where the team runs: the node of each thread. */
+    int team[MAX_NODES] = {0};
+    int nodes[MATMUL_STATS_THREADS];
+    int team_size = 1;
+    #pragma omp parallel num_threads(threads)
+    {
+        int t = omp_get_thread_num();
+        if (t < MATMUL_STATS_THREADS) nodes[t] = current_node();
+        #pragma omp single
+        team_size = omp_get_num_threads();
+    }
+    int recorded = team_size < MATMUL_STATS_THREADS ? team_size : MATMUL_STATS_THREADS;
+    for (int t = 0; t < recorded; t++) team[nodes[t]]++;
+
+    static const char* BIND[] = {"false", "true", "primary", "close", "spread"};
+    int bind = omp_get_proc_bind();
+    fprintf(out, "[numa] team of %d threads, proc_bind %s, %d places:", team_size,
+            bind >= 0 && bind < 5 ? BIND[bind] : "?", omp_get_num_places());
+    for (int i = 0; i < MAX_NODES; i++) {
+        if (team[i]) fprintf(out, "  N%d %d", i, team[i]);
+    }
+    fputc('\n', out);
+
+    /* "remote": pages of each thread's chunk that sit off that thread's node */
+    PLACEMENT p, sum = {{0}};
+    for (int b = 0; b < count; b++) {
+        if (!bufs[b].addr) continue;
+        if (placement(bufs[b].addr, bufs[b].len, team_size, nodes, recorded, &p)) {
+            fprintf(out, "[numa] move_pages failed: %s\n", strerror(errno));
+            return -1;
+        }
+        print_buffer(out, bufs[b].name, &p);
+        add_placement(&sum, &p);
+    }
+
+    MM_ARENA* arena = mm_arena();
+    if (arena->base && arena->touched && !placement(arena->base, arena->touched, team_size, nodes, recorded, &p)) {
+        print_buffer(out, "workspace", &p);
+        add_placement(&sum, &p);
+    }
+    print_buffer(out, "total", &sum);
+    return 0;
+}
@@ -0,0 +1,398 @@
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "kernels.h"
+#include "matio.h"
+
+/*
+ * Out-of-core multiply for operands larger than memory.  C is cut into
+ * R x W tiles and the k dimension into chunks of K; tile (i, j) is the sum
+ * over chunks p of A(i, p) * B(p, j), each product run through one
+ * R x K x W plan (edge panels are zero padded to that shape).  A loader
+ * thread copies the next pair of panels out of the mapped input files into
+ * the spare of two buffer slots while the caller computes on the other, so
+ * the disk reads behind those page faults overlap the compute.  A finished
+ * C tile is written with pwrite as soon as its last chunk is in.
+ *
+ * Input pages are dropped from the mapping once copied, so resident memory
+ * is the two slots, the C accumulator and the plan's workspace; the tile
+ * side is the largest multiple of OOC_STEP for which that fits the budget,
+ * then shrunk to split each dimension evenly.
+ */
+
+#define OOC_STEP 64
+#define OOC_NONE ((size_t)-1)
+#define PAGE 4096
+
+typedef struct OOC_INPUT {
+    char* map;
+    size_t map_len;
+    const uint* data;
+    size_t rows, cols, stride;
+} OOC_INPUT;
+
+typedef struct OOC_SLOT {
+    uint* A;                /* R x K */
+    uint* B;                /* K x W */
+    size_t a_panel;         /* index of the A panel in A, OOC_NONE if none */
+    int full;
+} OOC_SLOT;
+
+typedef struct OOC {
+    OOC_INPUT a, b;
+    size_t R, K, W;         /* tile shape */
+    size_t mt, kt, nt;      /* tile counts along m, k, n */
+    OOC_SLOT slot[2];
+
+    pthread_mutex_t lock;
+    pthread_cond_t ready;
+    int stop;
+    double io_seconds;
+} OOC;
+
+static int input_open(const char* path, OOC_INPUT* in){
+    memset(in, 0, sizeof(*in));
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+
+    MAT_HEADER hdr;
+    struct stat st;
+    int ok = !fstat(fd, &st) && pread(fd, &hdr, sizeof(hdr), 0) == sizeof(hdr)
+          && !memcmp(hdr.magic, MAT_MAGIC, 4) && hdr.version == MAT_VERSION && hdr.dtype == MAT_U32
+          && hdr.count <= 1 && hdr.stride >= hdr.cols && hdr.header_size >= MAT_HEADER_SIZE
+          && hdr.header_size % sizeof(uint) == 0
+          && (size_t)st.st_size >= hdr.header_size + hdr.rows*hdr.stride*sizeof(uint);
+    if (!ok) {
+        close(fd);
+        errno = EINVAL;
+        return -1;
+    }
+
+    in->map_len = hdr.header_size + hdr.rows*hdr.stride*sizeof(uint);
+    in->map = mmap(NULL, in->map_len, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (in->map == MAP_FAILED) {
+        in->map = NULL;
+        return -1;
+    }
+    /* Panels are strided; readahead is requested per row segment instead. */
+    madvise(in->map, in->map_len, MADV_RANDOM);
+
+    in->data = (const uint*)(in->map + hdr.header_size);
+    in->rows = hdr.rows;
+    in->cols = hdr.cols;
+    in->stride = hdr.stride;
+    return 0;
+}
+
+static void input_close(OOC_INPUT* in){
+    if (in->map) munmap(in->map, in->map_len);
+    in->map = NULL;
+}
+
+/* Page-aligned byte range of `in` holding rows [r0, r1). */
+static void row_pages(const OOC_INPUT* in, size_t r0, size_t r1, char** lo, size_t* len){
+    uintptr_t a = (uintptr_t)(in->data + r0*in->stride) & ~(uintptr_t)(PAGE - 1);
+    uintptr_t b = (uintptr_t)(in->data + r1*in->stride);
+    *lo = (char*)a;
+    *len = b - a;
+}
+
+/*
+ * dst (rows x cols, dense) = the block of `in` at (r0, c0), zero past the
+ * edge of the matrix.  All row segments are requested up front so their
+ * reads are in flight together; the source pages are dropped afterwards.
+ */
+static void copy_panel(const OOC_INPUT* in, size_t r0, size_t c0, size_t rows, size_t cols, uint* dst){
+    size_t nr = in->rows - r0 < rows ? in->rows - r0 : rows;
+    size_t nc = in->cols - c0 < cols ? in->cols - c0 : cols;
+
+    for(size_t r = 0; r < nr; r++){
+        uintptr_t a = (uintptr_t)(in->data + (r0 + r)*in->stride + c0);
+        uintptr_t lo = a & ~(uintptr_t)(PAGE - 1);
+        madvise((void*)lo, a + nc*sizeof(uint) - lo, MADV_WILLNEED);
+    }
+    for(size_t r = 0; r < rows; r++){
+        uint* out = dst + r*cols;
+        size_t c = 0;
+        if (r < nr) {
+            memcpy(out, in->data + (r0 + r)*in->stride + c0, nc*sizeof(uint));
+            c = nc;
+        }
+        memset(out + c, 0, (cols - c)*sizeof(uint));
+    }
+
+    char* lo;
+    size_t len;
+    row_pages(in, r0, r0 + nr, &lo, &len);
+    madvise(lo, len, MADV_DONTNEED);
+}
+
+static void* loader(void* arg){
+    OOC* o = arg;
+    size_t steps = o->mt * o->nt * o->kt;
+
+    for(size_t s = 0; s < steps; s++){
+        OOC_SLOT* slot = &o->slot[s & 1];
+        pthread_mutex_lock(&o->lock);
+        while (slot->full && !o->stop) pthread_cond_wait(&o->ready, &o->lock);
+        int stop = o->stop;
+        pthread_mutex_unlock(&o->lock);
+        if (stop) break;
+
+        double t0 = mm_now();
+        size_t i = s / (o->nt * o->kt), j = s / o->kt % o->nt, p = s % o->kt;
+        /* With one k chunk the A panel stays the same along a row of tiles. */
+        if (slot->a_panel != i*o->kt + p) {
+            copy_panel(&o->a, i*o->R, p*o->K, o->R, o->K, slot->A);
+            slot->a_panel = i*o->kt + p;
+        }
+        copy_panel(&o->b, p*o->K, j*o->W, o->K, o->W, slot->B);
+        o->io_seconds += mm_now() - t0;
+
+        pthread_mutex_lock(&o->lock);
+        slot->full = 1;
+        pthread_cond_broadcast(&o->ready);
+        pthread_mutex_unlock(&o->lock);
+    }
+    return NULL;
+}
+
+static int write_all(int fd, const void* buf, size_t len, off_t at){
+    const char* p = buf;
+    while (len) {
+        ssize_t w = pwrite(fd, p, len, at);
+        if (w < 0) {
+            if (errno == EINTR) continue;
+            return -1;
+        }
+        p += w;
+        at += w;
+        len -= w;
+    }
+    return 0;
+}
+
+static int output_create(const char* path, size_t m, size_t n){
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+
+    MAT_HEADER hdr = {0};
+    memcpy(hdr.magic, MAT_MAGIC, 4);
+    hdr.version = MAT_VERSION;
+    hdr.dtype = MAT_U32;
+    hdr.header_size = MAT_HEADER_SIZE;
+    hdr.alignment = MAT_ALIGN;
+    hdr.rows = m;
+    hdr.cols = n;
+    hdr.stride = n;
+    hdr.count = 1;
+    if (ftruncate(fd, MAT_HEADER_SIZE + m*n*sizeof(uint)) || write_all(fd, &hdr, sizeof(hdr), 0)) {
+        int err = errno;
+        close(fd);
+        errno = err;
+        return -1;
+    }
+    return fd;
+}
+
+static size_t ooc_bytes(const OOC* o){
+    size_t words = 2*(o->R*o->K + o->K*o->W) + o->R*o->W * (o->kt > 1 ? 2 : 1);
+    return words * sizeof(uint);
+}
+
+static size_t min2(size_t a, size_t b){
+    return a < b ? a : b;
+}
+
+/* Tile length for a dimension of d: at most t, splitting d evenly so the edge pads little. */
+static size_t tile_len(size_t d, size_t t){
+    size_t tiles = (d + t - 1) / t;
+    size_t len = (d + tiles - 1) / tiles;
+    return min2(d, (len + OOC_STEP - 1) / OOC_STEP * OOC_STEP);
+}
+
+/*
+ * Largest tile side whose buffers and plan workspace fit in `budget`; the
+ * plan is left initialised on `arena`.  The workspace counts the arena as
+ * resident (whole huge pages once it has them) plus the plan's heap.  -1
+ * with ENOMEM if even OOC_STEP doesn't fit.
+ */
+static int fit_tiles(OOC* o, size_t m, size_t k, size_t n, size_t budget, MATMUL_ALGO algo,
+                     const MATMUL_OPTS* opts, MATMUL_PLAN* plan, MM_ARENA* arena){
+    size_t t = OOC_STEP;
+    while (7 * (t + OOC_STEP) * (t + OOC_STEP) * sizeof(uint) <= budget && (t < m || t < k || t < n)) {
+        t += OOC_STEP;
+    }
+
+    for (;;) {
+        o->R = tile_len(m, t);
+        o->K = tile_len(k, t);
+        o->W = tile_len(n, t);
+        o->mt = (m + o->R - 1) / o->R;
+        o->kt = (k + o->K - 1) / o->K;
+        o->nt = (n + o->W - 1) / o->W;
+
+        if (mm_plan_init(plan, o->R, o->K, o->W, algo, opts, arena)) return -1;
+        size_t need = ooc_bytes(o) + plan->heap_bytes;
+        if (need + mm_arena_resident(arena) <= budget) return 0;
+
+        /* huge pages round the workspace up to 2 MiB; small pages may still fit */
+        int retry = !arena->small_pages && need + ((arena->touched + 4095) & ~(size_t)4095) <= budget;
+        mm_plan_fini(plan);
+        mm_arena_release(arena);
+        if (retry) {
+            arena->small_pages = 1;
+            continue;
+        }
+        if (t == OOC_STEP) {
+            errno = ENOMEM;
+            return -1;
+        }
+        t = (t - t / 8) / OOC_STEP * OOC_STEP;
+        if (t < OOC_STEP) t = OOC_STEP;
+    }
+}
+
+static int run(OOC* o, MATMUL_PLAN* plan, int fd, size_t m, size_t n, double* wait){
+    size_t R = o->R, W = o->W;
+    uint* acc = mm_alloc(R*W);
+    uint* tmp = o->kt > 1 ? mm_alloc(R*W) : NULL;
+    for (int i = 0; i < 2; i++) {
+        o->slot[i].A = mm_alloc(R*o->K);
+        o->slot[i].B = mm_alloc(o->K*W);
+        o->slot[i].a_panel = OOC_NONE;
+    }
+    int status = 0;
+    if (!acc || (o->kt > 1 && !tmp) || !o->slot[0].A || !o->slot[0].B || !o->slot[1].A || !o->slot[1].B) {
+        errno = ENOMEM;
+        status = -1;
+    }
+
+    pthread_t thread;
+    if (!status && (errno = pthread_create(&thread, NULL, loader, o))) status = -1;
+    if (status) {
+        free(acc);
+        free(tmp);
+        for (int i = 0; i < 2; i++) {
+            free(o->slot[i].A);
+            free(o->slot[i].B);
+        }
+        return -1;
+    }
+
+    size_t steps = o->mt * o->nt * o->kt;
+    for(size_t s = 0; s < steps && !status; s++){
+        OOC_SLOT* slot = &o->slot[s & 1];
+        double t0 = mm_now();
+        pthread_mutex_lock(&o->lock);
+        while (!slot->full) pthread_cond_wait(&o->ready, &o->lock);
+        pthread_mutex_unlock(&o->lock);
+        *wait += mm_now() - t0;
+
+        size_t i = s / (o->nt * o->kt), j = s / o->kt % o->nt, p = s % o->kt;
+        status = mm_plan_execute(plan, slot->A, slot->B, p ? tmp : acc);
+
+        pthread_mutex_lock(&o->lock);
+        slot->full = 0;
+        pthread_cond_broadcast(&o->ready);
+        pthread_mutex_unlock(&o->lock);
+
+        if (p) {
+            for(size_t x = 0; x < R*W; x++) acc[x] += tmp[x];
+        }
+        if (status || p != o->kt - 1) continue;
+
+        size_t r0 = i*R, c0 = j*W;
+        size_t nr = min2(R, m - r0), nc = min2(W, n - c0);
+        for(size_t r = 0; r < nr && !status; r++){
+            status = write_all(fd, acc + r*W, nc*sizeof(uint), MAT_HEADER_SIZE + ((r0 + r)*n + c0)*sizeof(uint));
+        }
+    }
+
+    int err = errno;
+    pthread_mutex_lock(&o->lock);
+    o->stop = 1;
+    pthread_cond_broadcast(&o->ready);
+    pthread_mutex_unlock(&o->lock);
+    pthread_join(thread, NULL);
+
+    free(acc);
+    free(tmp);
+    for (int i = 0; i < 2; i++) {
+        free(o->slot[i].A);
+        free(o->slot[i].B);
+    }
+    errno = err;
+    return status;
+}
+
+int matmul_ooc(const char* A_path, const char* B_path, const char* C_path, size_t budget,
+               MATMUL_ALGO algo, const MATMUL_OPTS* opts){
+    memset(mm_stats(), 0, sizeof(MATMUL_STATS));
+    if (!A_path || !B_path || !C_path) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    OOC o = {0};
+    if (input_open(A_path, &o.a)) return -1;
+    if (input_open(B_path, &o.b)) {
+        input_close(&o.a);
+        return -1;
+    }
+    size_t m = o.a.rows, k = o.a.cols, n = o.b.cols;
+    if (o.b.rows != k) {
+        input_close(&o.a);
+        input_close(&o.b);
+        errno = EINVAL;
+        return -1;
+    }
+
+    int fd = output_create(C_path, m, n);
+    if (fd < 0) {
+        input_close(&o.a);
+        input_close(&o.b);
+        return -1;
+    }
+
+    int status = 0;
+    double wait = 0;
+    MATMUL_PLAN plan = {0};
+    MM_ARENA arena = {0};
+    if (m && k && n) {
+        status = fit_tiles(&o, m, k, n, budget, algo, opts, &plan, &arena);
+        if (!status) {
+            pthread_mutex_init(&o.lock, NULL);
+            pthread_cond_init(&o.ready, NULL);
+            status = run(&o, &plan, fd, m, n, &wait);
+            pthread_cond_destroy(&o.ready);
+            pthread_mutex_destroy(&o.lock);
+
+            int err = errno;
+            mm_plan_fini(&plan);
+            errno = err;
+        }
+    }
+
+    int err = errno;
+    MATMUL_STATS* st = mm_stats();
+    st->workspace_bytes = status ? 0 : ooc_bytes(&o) + mm_arena_resident(&arena) + plan.heap_bytes;
+    st->io_seconds = o.io_seconds;
+    st->io_wait_seconds = wait;
+    mm_arena_release(&arena);
+    input_close(&o.a);
+    input_close(&o.b);
+    if (close(fd) && !status) {
+        err = errno;
+        status = -1;
+    }
+    errno = err;
+    return status;
+}
@@ -0,0 +1,135 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <omp.h>
+
+#include "kernels.h"
+#include "perf_events.h"
+
+/*
+ * Hardware counters for --perf.  Every event is opened on its own (no
+ * group) for each thread of the team, found by running one parallel region
+ * of that size: libgomp keeps those threads for later regions of the same
+ * size, which is where the kernels run.  Ungrouped events can be
+ * multiplexed independently, so counts are scaled by enabled / running.
+ */
+
+struct MATMUL_PERF {
+    int threads;
+    int fd[MATMUL_STATS_THREADS][MATMUL_PERF_EVENT_COUNT];
+};
+
+/* common/perf_events.h, shared with the lab2 / lab3 counters */
+#define EVENT(name, type, config) {name, type, config},
+static const struct {
+    const char* name;
+    uint32_t type;
+    uint64_t config;
+} EVENTS[] = {PERF_EVENTS(EVENT)};
+#undef EVENT
+
+_Static_assert(sizeof(EVENTS) / sizeof(EVENTS[0]) == MATMUL_PERF_EVENT_COUNT,
+               "MATMUL_PERF_EVENT must follow PERF_EVENTS");
+
+const char* matmul_perf_event_name(MATMUL_PERF_EVENT event){
+    return event >= 0 && event < MATMUL_PERF_EVENT_COUNT ? EVENTS[event].name : NULL;
+}
+
+static int open_event(MATMUL_PERF_EVENT event, pid_t tid){
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = EVENTS[event].type;
+    attr.config = EVENTS[event].config;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;    /* allowed at perf_event_paranoid 2 */
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, tid, -1, -1, 0);
+}
+
+MATMUL_PERF* matmul_perf_open(int threads){
+    if (threads <= 0) threads = omp_get_max_threads();
+    if (threads > MATMUL_STATS_THREADS) threads = MATMUL_STATS_THREADS;
+
+    MATMUL_PERF* perf = malloc(sizeof(MATMUL_PERF));
+    if (!perf) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    pid_t tids[MATMUL_STATS_THREADS];
+    int team = 1;
+    #pragma omp parallel num_threads(threads)
+    {
+        tids[omp_get_thread_num()] = (pid_t)syscall(SYS_gettid);
+        #pragma omp single
+        team = omp_get_num_threads();
+    }
+    perf->threads = team;
+
+    int opened = 0, err = ENOENT;
+    for (int t = 0; t < team; t++) {
+        for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) {
+            perf->fd[t][e] = open_event(e, tids[t]);
+            if (perf->fd[t][e] >= 0) opened++;
+            else err = errno;
+        }
+    }
+    if (!opened) {
+        free(perf);
+        errno = err;
+        return NULL;
+    }
+    return perf;
+}
+
+static void each_fd(MATMUL_PERF* perf, unsigned long request){
+    for (int t = 0; t < perf->threads; t++) {
+        for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) {
+            if (perf->fd[t][e] >= 0) ioctl(perf->fd[t][e], request, 0);
+        }
+    }
+}
+
+void matmul_perf_start(MATMUL_PERF* perf){
+    each_fd(perf, PERF_EVENT_IOC_RESET);
+    each_fd(perf, PERF_EVENT_IOC_ENABLE);
+}
+
+/* Scaled count of one fd, MATMUL_PERF_NA if it was never scheduled. */
+static uint64_t read_event(int fd){
+    uint64_t v[3];      /* value, time enabled, time running */
+    if (fd < 0 || read(fd, v, sizeof(v)) != sizeof(v) || !v[2]) return MATMUL_PERF_NA;
+    if (v[2] < v[1]) return (uint64_t)((double)v[0] * v[1] / v[2]);
+    return v[0];
+}
+
+void matmul_perf_stop(MATMUL_PERF* perf, MATMUL_PERF_COUNTS* out){
+    each_fd(perf, PERF_EVENT_IOC_DISABLE);
+
+    out->threads = perf->threads;
+    for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) {
+        out->total[e] = MATMUL_PERF_NA;
+        for (int t = 0; t < perf->threads; t++) {
+            uint64_t v = read_event(perf->fd[t][e]);
+            out->thread[t][e] = v;
+            if (v == MATMUL_PERF_NA) continue;
+            out->total[e] = out->total[e] == MATMUL_PERF_NA ? v : out->total[e] + v;
+        }
+    }
+}
+
+void matmul_perf_close(MATMUL_PERF* perf){
+    if (!perf) return;
+    for (int t = 0; t < perf->threads; t++) {
+        for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) {
+            if (perf->fd[t][e] >= 0) close(perf->fd[t][e]);
+        }
+    }
+    free(perf);
+}
@@ -0,0 +1,234 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <omp.h>
+
+#include "kernels.h"
+
+/* Tuning-file values for one engine, with any explicit opts taking precedence. */
+static MM_ENGINE_TUNING engine_tuning(const MM_ENGINE_TUNING* base, const MATMUL_OPTS* opts){
+    MM_ENGINE_TUNING t = *base;
+    if (opts && opts->cutoff) t.cutoff = opts->cutoff;
+    if (opts && opts->task_cutoff) t.task_cutoff = opts->task_cutoff;
+    if (opts && opts->leaf != MATMUL_LEAF_DEFAULT && opts->leaf < MATMUL_LEAF_COUNT) t.leaf = opts->leaf;
+    return t;
+}
+
+static int engine_tasks(MATMUL_ALGO algo){
+    return algo == MATMUL_PARALLEL || algo == MATMUL_SIMD;
+}
+
+int mm_plan_init(MATMUL_PLAN* plan, size_t m, size_t k, size_t n, MATMUL_ALGO algo,
+                 const MATMUL_OPTS* opts, MM_ARENA* arena){
+    double t = mm_now();
+    memset(plan, 0, sizeof(*plan));
+    if (algo >= MATMUL_ALGO_COUNT || (algo == MATMUL_BLOCK && (m != k || k != n))) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    plan->m = m;
+    plan->k = k;
+    plan->n = n;
+    plan->algo = algo;
+    plan->threads = opts && opts->threads > 0 ? opts->threads : omp_get_max_threads();
+    plan->arena = arena;
+    plan->mark = arena->top;
+    plan->profile = opts && opts->profile;
+
+    if (!m || !n || !k || algo == MATMUL_SLOW) return 0;
+
+    MM_TUNING tuning;
+    mm_tuning(plan->threads, &tuning);
+    switch (algo) {
+    case MATMUL_BLOCK:
+        plan->block_cutoff = opts && opts->cutoff ? opts->cutoff : tuning.block_cutoff;
+        break;
+    case MATMUL_STRASSEN: plan->tuning = engine_tuning(&tuning.strass, opts); break;
+    case MATMUL_PARALLEL: plan->tuning = engine_tuning(&tuning.parallel, opts); break;
+    case MATMUL_SIMD:     plan->tuning = engine_tuning(&tuning.simd, opts); break;
+    case MATMUL_WINOGRAD:
+    case MATMUL_MORTON:   plan->tuning = engine_tuning(&tuning.winograd, opts); break;
+    default: break;
+    }
+    if (engine_tasks(algo)) plan->tuning.task_cutoff = mm_strassen_task_cutoff(&plan->tuning, m, k, n, plan->threads);
+
+    /*
+     * Morton pads every operand to one power-of-two multiple of the tile;
+     * when that is mostly padding (thin or very rectangular shapes) the
+     * strided Winograd does less work.
+     */
+    if (algo == MATMUL_MORTON) {
+        mm_morton_shape(m, k, n, plan->tuning.cutoff, &plan->tile, &plan->levels);
+        double side = (double)(plan->tile << plan->levels);
+        if (side * side * side > 2.0 * m * k * n) plan->algo = algo = MATMUL_WINOGRAD;
+    }
+
+    /* packed and morton pack B from its own layout; the rest read B^T */
+    size_t f_bytes = algo == MATMUL_MORTON || algo == MATMUL_PACKED ? 0 : n*k*sizeof(uint);
+    size_t bytes = MM_ARENA_LEN(f_bytes);
+    size_t w_bytes = 0;
+    size_t cutoff = plan->tuning.cutoff ? plan->tuning.cutoff : 1;
+    switch (algo) {
+    case MATMUL_STRASSEN:
+    case MATMUL_PARALLEL:
+    case MATMUL_SIMD:
+        bytes += mm_strassen_bytes(m, k, n, &plan->tuning, engine_tasks(algo), plan->threads);
+        break;
+    case MATMUL_WINOGRAD:
+        w_bytes = mm_winograd_bytes(m, k, n, &plan->tuning);
+        bytes += MM_ARENA_LEN(w_bytes) + mm_leaf_packs_bytes(plan->tuning.leaf, m, k, n, cutoff, 1);
+        break;
+    case MATMUL_MORTON:
+        w_bytes = mm_morton_bytes(plan->tile, plan->levels);
+        bytes += MM_ARENA_LEN(w_bytes) + mm_leaf_packs_bytes(plan->tuning.leaf, plan->tile, plan->tile,
+                                                             plan->tile, plan->tile, 1);
+        break;
+    case MATMUL_PACKED:
+        bytes += mm_pack_bytes(m, k, n, plan->threads);
+        break;
+    default: break;
+    }
+
+    if (mm_arena_reserve(arena, bytes, opts && opts->numa ? plan->threads : 1)) {
+        errno = ENOMEM;
+        return -1;
+    }
+    if (f_bytes) plan->F = mm_arena_push(arena, f_bytes);
+
+    switch (algo) {
+    case MATMUL_BLOCK:
+        plan->block = mm_block_tree(n, plan->block_cutoff);
+        if (!plan->block) {
+            mm_plan_fini(plan);
+            errno = ENOMEM;
+            return -1;
+        }
+        plan->heap_bytes = mm_block_bytes(n, plan->block_cutoff);
+        break;
+    case MATMUL_STRASSEN:
+    case MATMUL_PARALLEL:
+    case MATMUL_SIMD:
+        plan->tree = mm_strassen_tree(arena, m, k, n, &plan->tuning, engine_tasks(algo), plan->threads,
+                                      &plan->packs);
+        break;
+    case MATMUL_WINOGRAD:
+        plan->W = mm_arena_push(arena, w_bytes);
+        mm_leaf_packs_init(&plan->packs, arena, plan->tuning.leaf, m, k, n, cutoff, 1);
+        break;
+    case MATMUL_MORTON:
+        plan->W = mm_arena_push(arena, w_bytes);
+        mm_leaf_packs_init(&plan->packs, arena, plan->tuning.leaf, plan->tile, plan->tile, plan->tile,
+                           plan->tile, 1);
+        break;
+    case MATMUL_PACKED:
+        mm_pack_init(&plan->pack, arena, m, k, n, plan->threads);
+        break;
+    default: break;
+    }
+
+    mm_phase(MATMUL_PHASE_SETUP, t);
+    return 0;
+}
+
+int mm_plan_execute(MATMUL_PLAN* plan, const uint* A, const uint* B, uint* C){
+    size_t m = plan->m, k = plan->k, n = plan->n;
+
+    if (!m || !n) return 0;
+    if (!k) {
+        memset(C, 0, m*n*sizeof(uint));
+        return 0;
+    }
+    double t = mm_now();
+    if (plan->algo == MATMUL_SLOW) {
+        int status = mm_slow(A, B, C, m, k, n);
+        mm_phase(MATMUL_PHASE_COMPUTE, t);
+        return status;
+    }
+    if (plan->algo == MATMUL_MORTON) {
+        mm_morton_run(A, B, C, m, k, n, plan->tile, plan->levels, mm_leaf_fn(plan->tuning.leaf),
+                      &plan->packs, plan->threads, plan->W);
+        return 0;
+    }
+    if (plan->algo == MATMUL_PACKED) {
+        /* packing is interleaved with the panels, so it counts as compute */
+        int failed = gemm_packed_B(A, k, B, n, C, n, m, k, n, plan->threads, &plan->pack);
+        mm_phase(MATMUL_PHASE_COMPUTE, t);
+        if (!failed) return 0;
+        errno = ENOMEM;
+        return -1;
+    }
+
+    uint* F = plan->F;
+    mm_transpose_B(B, F, k, n, plan->threads);
+    t = mm_phase(MATMUL_PHASE_TRANSPOSE, t);
+
+    int status = 0;
+    switch (plan->algo) {
+    case MATMUL_TRANSPOSE: status = mm_transpose(A, F, C, m, k, n); break;
+    case MATMUL_BLOCK:     mm_block_run(A, F, C, n, plan->block_cutoff, plan->block); break;
+    case MATMUL_STRASSEN:
+    case MATMUL_PARALLEL:
+    case MATMUL_SIMD:
+        mm_strassen_run(A, F, C, m, k, n, &plan->tuning, engine_tasks(plan->algo), plan->threads,
+                        plan->profile, plan->tree, &plan->packs);
+        break;
+    case MATMUL_WINOGRAD:  mm_winograd_run(A, F, C, m, k, n, &plan->tuning, plan->W, &plan->packs); break;
+    default: break;
+    }
+    mm_phase(MATMUL_PHASE_COMPUTE, t);
+
+    if (status) errno = ENOMEM;
+    return status;
+}
+
+void mm_plan_fini(MATMUL_PLAN* plan){
+    mm_block_free(plan->block, plan->n, plan->block_cutoff);
+    if (plan->arena) mm_arena_pop(plan->arena, plan->mark);
+    plan->block = NULL;
+}
+
+MATMUL_PLAN* matmul_plan_create_mkn(size_t m, size_t k, size_t n, MATMUL_ALGO algo, const MATMUL_OPTS* opts){
+    MATMUL_PLAN* plan = malloc(sizeof(MATMUL_PLAN));
+    if (!plan) {
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    MM_ARENA own = {0};
+    if (mm_plan_init(plan, m, k, n, algo, opts, &own)) {
+        mm_arena_release(&own);
+        free(plan);
+        return NULL;
+    }
+    plan->own_arena = own;
+    plan->arena = &plan->own_arena;
+
+    /* Start the OpenMP team now so the first execute doesn't pay for it. */
+    if (algo == MATMUL_PARALLEL || algo == MATMUL_SIMD || algo == MATMUL_PACKED) {
+        #pragma omp parallel num_threads(plan->threads)
+        {
+        }
+    }
+    return plan;
+}
+
+MATMUL_PLAN* matmul_plan_create(size_t n, MATMUL_ALGO algo, const MATMUL_OPTS* opts){
+    return matmul_plan_create_mkn(n, n, n, algo, opts);
+}
+
+int matmul_plan_execute(MATMUL_PLAN* plan, const uint32_t* A, const uint32_t* B, uint32_t* C){
+    if (!plan || !A || !B || !C) {
+        errno = EINVAL;
+        return -1;
+    }
+    memset(mm_stats(), 0, sizeof(MATMUL_STATS));
+    return mm_plan_execute(plan, A, B, C);
+}
+
+void matmul_plan_destroy(MATMUL_PLAN* plan){
+    if (!plan) return;
+    mm_plan_fini(plan);
+    mm_arena_release(&plan->own_arena);
+    free(plan);
+}
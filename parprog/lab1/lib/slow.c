@@ -0,0 +1,14 @@
+#include "kernels.h"
+
+int mm_slow(const uint* A, const uint* B, uint* D, size_t m, size_t k, size_t n){
+    for(size_t i = 0; i < m; i++){
+        for(size_t j = 0; j < n; j++){
+            uint64_t sum = 0;
+            for(size_t p = 0; p < k; p++){
+                sum += (uint64_t)A[i*k+p]*B[p*n+j];
+            }
+            D[i*n+j] = (uint)sum;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,493 @@
+#include <string.h>
+#include <omp.h>
+#include <immintrin.h>
+
+#include "kernels.h"
+
+/*
+ * Strassen engine shared by the strass, parallel and simd algorithms; they
+ * differ only in the leaf kernel and in whether the seven products of a
+ * level are spawned as OpenMP tasks.
+ *
+ * Shapes are arbitrary: A is m x k, F = B^T is n x k, D is m x n.  Each
+ * level runs Strassen on the even-sized leading part and peels the odd
+ * row / column / inner index off with leaf and rank-1 fix-ups.
+ *
+ * M1, M2, M3 and M6 are computed straight into the C11, C21, C12 and C22
+ * quadrants of D; only M4, M5 and M7 need buffers, and one combine pass
+ * folds them in.
+ *
+ * Task levels are the top ones, breadth first: a level spawns its seven
+ * products while its smallest side is at least task_cutoff, and everything
+ * below runs depth first inside one task.  With task_cutoff=depth the
+ * cutoff is chosen from the thread count so that there are about
+ * DEPTH_TASKS_PER_THREAD sequential subtrees per thread.  Tasked runs
+ * record per-thread busy time (sequential subtrees, operand sums,
+ * combines, peels) in the caller's MATMUL_STATS.  Profiled untasked runs
+ * record the inclusive time of each recursion depth and the time spent
+ * forming operands, combining and peeling there instead.
+ */
+
+typedef struct STRASS_PROF {
+    int depth;
+    double combine;
+    double* level;          /* MATMUL_STATS.level_seconds */
+} STRASS_PROF;
+
+typedef struct STRASS_CFG {
+    MM_LEAF leaf;
+    MM_LEAF_SUM leaf_sum;   /* fused leaf, NULL if the leaf needs formed operands */
+    size_t cutoff;          /* recurse while every dimension is above this */
+    size_t task_cutoff;     /* spawn tasks while every dimension is at least this */
+    int tasks;
+    const MM_PACKS* packs;  /* leaf packing buffers, one set per thread */
+    double* busy;           /* per-thread busy seconds, NULL when not tasked */
+    STRASS_PROF* prof;      /* NULL unless profiling an untasked run */
+} STRASS_CFG;
+
+#define STRASS_M 3
+#define DEPTH_TASKS_PER_THREAD 8
+
+typedef struct TREE_BF {
+    uint *M[STRASS_M];     /* M4, M5, M7 */
+    uint *tempA[7];
+    uint *tempB[7];
+    struct TREE_BF** branch;
+} TREE_BF;
+
+static size_t min3(size_t a, size_t b, size_t c){
+    size_t r = a < b ? a : b;
+    return r < c ? r : c;
+}
+
+static int is_leaf(const STRASS_CFG* cfg, size_t m, size_t k, size_t n){
+    return min3(m, k, n) <= cfg->cutoff;
+}
+
+static int use_tasks(const STRASS_CFG* cfg, size_t m, size_t k, size_t n){
+    return cfg->tasks && min3(m, k, n) >= cfg->task_cutoff;
+}
+
+static int operand_sets(const STRASS_CFG* cfg, size_t m, size_t k, size_t n){
+    if (cfg->leaf_sum && is_leaf(cfg, m / 2, k / 2, n / 2)) return 0;
+    return use_tasks(cfg, m, k, n) ? 7 : 1;
+}
+
+/* Distinct subtrees below a level: tasked products run concurrently. */
+static int subtrees(const STRASS_CFG* cfg, size_t m, size_t k, size_t n){
+    return use_tasks(cfg, m, k, n) ? 7 : 1;
+}
+
+static size_t node_bytes(size_t m, size_t k, size_t n, const STRASS_CFG* cfg){
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    size_t words = STRASS_M * m2 * n2 + operand_sets(cfg, m, k, n) * (m2 * k2 + n2 * k2);
+    return MM_ARENA_LEN(sizeof(TREE_BF)) + MM_ARENA_LEN(7 * sizeof(TREE_BF*))
+         + MM_ARENA_LEN(words * sizeof(uint));
+}
+
+/* Arena bytes init_tree will push for an m x k x n problem. */
+static size_t tree_bytes(size_t m, size_t k, size_t n, const STRASS_CFG* cfg){
+    if (is_leaf(cfg, m, k, n)) return 0;
+    return node_bytes(m, k, n, cfg) + subtrees(cfg, m, k, n) * tree_bytes(m / 2, k / 2, n / 2, cfg);
+}
+
+/*
+ * Levels that spawn tasks need private operand buffers and subtrees for
+ * each of the seven products; sequential levels share one tempA/tempB
+ * pair and one subtree, and the level above a fused leaf needs no
+ * operand buffers at all.  Everything comes from the arena, which the
+ * caller has reserved tree_bytes() in.
+ */
+static TREE_BF* init_tree(size_t m, size_t k, size_t n, const STRASS_CFG* cfg, MM_ARENA* arena) {
+    if (is_leaf(cfg, m, k, n)) {
+        return NULL;
+    }
+
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+    size_t a_len = m2 * k2, b_len = n2 * k2, m_len = m2 * n2;
+    int sets = operand_sets(cfg, m, k, n);
+
+    TREE_BF* node = mm_arena_push(arena, sizeof(TREE_BF));
+    node->branch = mm_arena_push(arena, 7 * sizeof(TREE_BF*));
+    uint* workspace = mm_arena_push(arena, (STRASS_M * m_len + sets * (a_len + b_len)) * sizeof(uint));
+
+    for (int i = 0; i < STRASS_M; ++i) node->M[i] = workspace + i * m_len;
+    uint* temp = workspace + STRASS_M * m_len;
+    for (int i = 0; i < 7; ++i) {
+        int s = sets == 7 ? i : 0;
+        node->tempA[i] = temp + s * (a_len + b_len);
+        node->tempB[i] = node->tempA[i] + a_len;
+    }
+
+    int shared = subtrees(cfg, m, k, n) == 1;
+    for (int i = 0; i < 7; ++i) {
+        node->branch[i] = shared && i ? node->branch[0] : init_tree(m2, k2, n2, cfg, arena);
+    }
+
+    return node;
+}
+
+/* Materialises a two-term operand into dst (rows x cols, compact). */
+static const uint* form(MM_OPERAND op, size_t ld, size_t rows, size_t cols, uint* dst, size_t* dst_ld){
+    if (!op.Y) {
+        *dst_ld = ld;
+        return op.X;
+    }
+
+    for(size_t i = 0; i < rows; i++){
+        const uint* x = op.X + i*ld;
+        const uint* y = op.Y + i*ld;
+        uint* d = dst + i*cols;
+        if (op.sign > 0) for(size_t j = 0; j < cols; j++) d[j] = x[j] + y[j];
+        else             for(size_t j = 0; j < cols; j++) d[j] = x[j] - y[j];
+    }
+    *dst_ld = cols;
+    return dst;
+}
+
+static void strass(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                   size_t m, size_t k, size_t n, TREE_BF* buffers, const STRASS_CFG* cfg);
+
+/* Timed sections contain no task scheduling points, so they stay on one thread. */
+static double busy_start(const STRASS_CFG* cfg){
+    return cfg->busy ? mm_now() : 0;
+}
+
+static void busy_stop(const STRASS_CFG* cfg, double t0){
+    if (!cfg->busy) return;
+    int id = omp_get_thread_num();
+    if (id < MATMUL_STATS_THREADS) cfg->busy[id] += mm_now() - t0;
+}
+
+static double prof_start(const STRASS_CFG* cfg){
+    return cfg->prof ? mm_now() : 0;
+}
+
+static void prof_combine(const STRASS_CFG* cfg, double t0){
+    if (cfg->prof) cfg->prof->combine += mm_now() - t0;
+}
+
+static void prof_level(const STRASS_CFG* cfg, double t0){
+    STRASS_PROF* p = cfg->prof;
+    if (p && p->depth < MATMUL_STATS_LEVELS) p->level[p->depth] += mm_now() - t0;
+}
+
+static void product(const MM_OPERAND* a, const MM_OPERAND* b, size_t lda, size_t ldf,
+                    size_t m2, size_t k2, size_t n2, uint* tempA, uint* tempB, uint* M, size_t ldm,
+                    TREE_BF* branch, const STRASS_CFG* cfg){
+    double t0 = busy_start(cfg);
+    if (cfg->leaf_sum && is_leaf(cfg, m2, k2, n2)) {
+        cfg->leaf_sum(*a, lda, *b, ldf, M, ldm, m2, k2, n2, cfg->packs);
+        busy_stop(cfg, t0);
+        return;
+    }
+
+    size_t ta_ld, tb_ld;
+    double f0 = prof_start(cfg);
+    const uint* tA = form(*a, lda, m2, k2, tempA, &ta_ld);
+    const uint* tB = form(*b, ldf, n2, k2, tempB, &tb_ld);
+    prof_combine(cfg, f0);
+    if (use_tasks(cfg, m2, k2, n2)) {
+        busy_stop(cfg, t0);
+        strass(tA, ta_ld, tB, tb_ld, M, ldm, m2, k2, n2, branch, cfg);
+        return;
+    }
+    strass(tA, ta_ld, tB, tb_ld, M, ldm, m2, k2, n2, branch, cfg);
+    busy_stop(cfg, t0);
+}
+
+/*
+ * Rows [i0, i1) of the combine, with C11..C22 holding M1, M3, M2, M6:
+ *   C22 += C11 - C21 + C12,  C11 += M4 - M5 + M7,  C21 += M4,  C12 += M5
+ */
+static void combine(uint* D, size_t ldd, uint* const* M, size_t i0, size_t i1, size_t m2, size_t n2){
+    for(size_t i = i0; i < i1; i++){
+        uint* c11 = D + i*ldd;
+        uint* c12 = c11 + n2;
+        uint* c21 = D + (i + m2)*ldd;
+        uint* c22 = c21 + n2;
+        const uint* m4 = M[0] + i*n2;
+        const uint* m5 = M[1] + i*n2;
+        const uint* m7 = M[2] + i*n2;
+
+        size_t j = 0;
+#ifdef __AVX2__
+        for(; j + 8 <= n2; j += 8){
+            __m256i x11 = _mm256_loadu_si256((const __m256i*)(c11 + j));
+            __m256i x12 = _mm256_loadu_si256((const __m256i*)(c12 + j));
+            __m256i x21 = _mm256_loadu_si256((const __m256i*)(c21 + j));
+            __m256i x22 = _mm256_loadu_si256((const __m256i*)(c22 + j));
+            __m256i y4 = _mm256_loadu_si256((const __m256i*)(m4 + j));
+            __m256i y5 = _mm256_loadu_si256((const __m256i*)(m5 + j));
+            __m256i y7 = _mm256_loadu_si256((const __m256i*)(m7 + j));
+
+            x22 = _mm256_add_epi32(x22, _mm256_add_epi32(_mm256_sub_epi32(x11, x21), x12));
+            x11 = _mm256_add_epi32(x11, _mm256_add_epi32(_mm256_sub_epi32(y4, y5), y7));
+            x21 = _mm256_add_epi32(x21, y4);
+            x12 = _mm256_add_epi32(x12, y5);
+
+            _mm256_storeu_si256((__m256i*)(c11 + j), x11);
+            _mm256_storeu_si256((__m256i*)(c12 + j), x12);
+            _mm256_storeu_si256((__m256i*)(c21 + j), x21);
+            _mm256_storeu_si256((__m256i*)(c22 + j), x22);
+        }
+#endif
+        for(; j < n2; j++){
+            c22[j] += c11[j] - c21[j] + c12[j];
+            c11[j] += m4[j] - m5[j] + m7[j];
+            c21[j] += m4[j];
+            c12[j] += m5[j];
+        }
+    }
+}
+
+void mm_strassen_peel(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                      size_t m, size_t k, size_t n, MM_LEAF leaf, const MM_PACKS* packs){
+    size_t me = m & ~(size_t)1, ke = k & ~(size_t)1, ne = n & ~(size_t)1;
+
+    if (ke != k) {
+        for(size_t i = 0; i < me; i++){
+            uint a = A[i*lda + ke];
+            for(size_t j = 0; j < ne; j++){
+                D[i*ldd + j] += a * F[j*ldf + ke];
+            }
+        }
+    }
+    if (me != m) {
+        leaf(A + me*lda, lda, F, ldf, D + me*ldd, ldd, 1, k, n, packs);
+    }
+    if (ne != n) {
+        leaf(A, lda, F + ne*ldf, ldf, D + ne, ldd, me, k, 1, packs);
+    }
+}
+
+static void strass(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                   size_t m, size_t k, size_t n, TREE_BF* buffers, const STRASS_CFG* cfg) {
+    double p0 = prof_start(cfg);
+    if (is_leaf(cfg, m, k, n)) {
+        cfg->leaf(A, lda, F, ldf, D, ldd, m, k, n, cfg->packs);
+        prof_level(cfg, p0);
+        return;
+    }
+
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+
+    const uint* A11 = A;
+    const uint* A12 = A + k2;
+    const uint* A21 = A + m2 * lda;
+    const uint* A22 = A + m2 * lda + k2;
+
+    const uint* BT11 = F;
+    const uint* BT12 = F + k2;
+    const uint* BT21 = F + n2 * ldf;
+    const uint* BT22 = F + n2 * ldf + k2;
+
+    const MM_OPERAND ops[7][2] = {
+        {{A11, A22,  1}, {BT11, BT22,  1}},
+        {{A21, A22,  1}, {BT11, NULL,  0}},
+        {{A11, NULL, 0}, {BT21, BT22, -1}},
+        {{A22, NULL, 0}, {BT12, BT11, -1}},
+        {{A11, A12,  1}, {BT22, NULL,  0}},
+        {{A21, A11, -1}, {BT11, BT21,  1}},
+        {{A12, A22, -1}, {BT12, BT22,  1}},
+    };
+
+    uint** M = buffers->M;
+    uint* out[7] = {D, D + m2*ldd, D + n2, M[0], M[1], D + m2*ldd + n2, M[2]};
+    const size_t ldo[7] = {ldd, ldd, ldd, n2, n2, ldd, n2};
+
+    if (use_tasks(cfg, m, k, n)) {
+        for (int i = 0; i < 7; ++i) {
+            #pragma omp task firstprivate(i) shared(ops, buffers, out, ldo) untied
+            product(&ops[i][0], &ops[i][1], lda, ldf, m2, k2, n2,
+                    buffers->tempA[i], buffers->tempB[i], out[i], ldo[i], buffers->branch[i], cfg);
+        }
+        #pragma omp taskwait
+
+        size_t rows = 16384 / n2 + 1;
+        size_t chunks = (m2 + rows - 1) / rows;
+        #pragma omp taskloop grainsize(1) shared(M)
+        for(size_t c = 0; c < chunks; c++){
+            double t0 = busy_start(cfg);
+            size_t i1 = (c + 1) * rows < m2 ? (c + 1) * rows : m2;
+            combine(D, ldd, M, c * rows, i1, m2, n2);
+            busy_stop(cfg, t0);
+        }
+
+        double t0 = busy_start(cfg);
+        mm_strassen_peel(A, lda, F, ldf, D, ldd, m, k, n, cfg->leaf, cfg->packs);
+        busy_stop(cfg, t0);
+    } else {
+        if (cfg->prof) cfg->prof->depth++;
+        for (int i = 0; i < 7; ++i) {
+            product(&ops[i][0], &ops[i][1], lda, ldf, m2, k2, n2,
+                    buffers->tempA[i], buffers->tempB[i], out[i], ldo[i], buffers->branch[i], cfg);
+        }
+        if (cfg->prof) cfg->prof->depth--;
+        double c0 = prof_start(cfg);
+        combine(D, ldd, M, 0, m2, m2, n2);
+        mm_strassen_peel(A, lda, F, ldf, D, ldd, m, k, n, cfg->leaf, cfg->packs);
+        prof_combine(cfg, c0);
+        prof_level(cfg, p0);
+    }
+}
+
+static void run(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                const STRASS_CFG* cfg, int threads, int profile, TREE_BF* root) {
+    if (!cfg->tasks && !profile) {
+        strass(A, k, F, k, D, n, m, k, n, root, cfg);
+        return;
+    }
+    if (!cfg->tasks) {
+        MATMUL_STATS* st = mm_stats();
+        STRASS_PROF prof = {0, 0, st->level_seconds};
+        STRASS_CFG profiled = *cfg;
+        profiled.prof = &prof;
+        strass(A, k, F, k, D, n, m, k, n, root, &profiled);
+
+        /* the caller books the whole run as compute */
+        st->phase_seconds[MATMUL_PHASE_COMBINE] += prof.combine;
+        st->phase_seconds[MATMUL_PHASE_COMPUTE] -= prof.combine;
+        st->levels = 0;
+        for (int l = 0; l < MATMUL_STATS_LEVELS; l++) {
+            if (st->level_seconds[l] > 0) st->levels = l + 1;
+        }
+        return;
+    }
+
+    if (threads <= 0) threads = omp_get_max_threads();
+
+    MATMUL_STATS* st = mm_stats();
+    memset(st->busy_seconds, 0, sizeof(st->busy_seconds));
+    STRASS_CFG timed = *cfg;
+    timed.busy = st->busy_seconds;
+
+    double t0 = mm_now();
+    #pragma omp parallel num_threads(threads)
+    {
+        #pragma omp single nowait
+        {
+            st->team_threads = omp_get_num_threads();
+            if (use_tasks(cfg, m, k, n)) {
+                strass(A, k, F, k, D, n, m, k, n, root, &timed);
+            } else {
+                double s0 = mm_now();
+                strass(A, k, F, k, D, n, m, k, n, root, cfg);
+                busy_stop(&timed, s0);
+            }
+        }
+    }
+    st->team_seconds = mm_now() - t0;
+}
+
+MM_LEAF mm_leaf_fn(MATMUL_LEAF leaf){
+    switch (leaf) {
+    case MATMUL_LEAF_DOT:   return leaf_dot;
+    case MATMUL_LEAF_AVX2:  return leaf_dot_avx2;
+    case MATMUL_LEAF_FIXED: return leaf_fixed;
+    default:                return leaf_packed;
+    }
+}
+
+MM_LEAF_SUM mm_leaf_sum_fn(MATMUL_LEAF leaf){
+    switch (leaf) {
+    case MATMUL_LEAF_DOT:
+    case MATMUL_LEAF_AVX2:
+    case MATMUL_LEAF_FIXED: return NULL;
+    default:                return leaf_packed_sum;
+    }
+}
+
+/*
+ * Buffer sets `leaf` needs for `threads` (0 if it doesn't pack), with
+ * m, k, n cut to the largest leaf: every side halved until one is at
+ * most cutoff.  Only the peels are larger, and they block to fit.
+ */
+static int leaf_packs_threads(MATMUL_LEAF leaf, size_t* m, size_t* k, size_t* n, size_t cutoff, int threads){
+    if (leaf == MATMUL_LEAF_DOT || leaf == MATMUL_LEAF_AVX2) return 0;
+    while (min3(*m, *k, *n) > cutoff) {
+        *m /= 2; *k /= 2; *n /= 2;
+    }
+    return threads > 1 ? threads : 1;
+}
+
+size_t mm_leaf_packs_bytes(MATMUL_LEAF leaf, size_t m, size_t k, size_t n, size_t cutoff, int threads){
+    threads = leaf_packs_threads(leaf, &m, &k, &n, cutoff, threads);
+    if (!threads) return 0;
+    return MM_ARENA_LEN(threads * sizeof(MM_PACK)) + threads * mm_pack_bytes(m, k, n, 1);
+}
+
+void mm_leaf_packs_init(MM_PACKS* packs, MM_ARENA* arena, MATMUL_LEAF leaf,
+                        size_t m, size_t k, size_t n, size_t cutoff, int threads){
+    packs->threads = leaf_packs_threads(leaf, &m, &k, &n, cutoff, threads);
+    packs->pack = NULL;
+    if (!packs->threads) return;
+    packs->pack = mm_arena_push(arena, packs->threads * sizeof(MM_PACK));
+    for (int i = 0; i < packs->threads; i++) mm_pack_init(&packs->pack[i], arena, m, k, n, 1);
+}
+
+static STRASS_CFG make_cfg(const MM_ENGINE_TUNING* t, int tasks){
+    const STRASS_CFG cfg = {mm_leaf_fn(t->leaf), mm_leaf_sum_fn(t->leaf),
+                            t->cutoff ? t->cutoff : 1, t->task_cutoff, tasks, NULL, NULL, NULL};
+    return cfg;
+}
+
+size_t mm_strassen_task_cutoff(const MM_ENGINE_TUNING* t, size_t m, size_t k, size_t n, int threads){
+    if (t->task_cutoff != MATMUL_TASK_DEPTH) return t->task_cutoff;
+    if (threads <= 0) threads = omp_get_max_threads();
+
+    size_t cutoff = t->cutoff ? t->cutoff : 1;
+    size_t side = min3(m, k, n);
+    size_t want = (size_t)DEPTH_TASKS_PER_THREAD * threads;
+    size_t depth = 0, subtrees = 1;
+    while (threads > 1 && subtrees < want && (side >> depth) > cutoff) {
+        depth++;
+        subtrees *= 7;
+    }
+    return depth ? side >> (depth - 1) : (size_t)-1;
+}
+
+/* Tasked runs have leaves on every thread of the team at once. */
+static int leaf_threads(int tasks, int threads){
+    if (!tasks) return 1;
+    return threads > 0 ? threads : omp_get_max_threads();
+}
+
+size_t mm_strassen_bytes(size_t m, size_t k, size_t n, const MM_ENGINE_TUNING* t, int tasks, int threads){
+    const STRASS_CFG cfg = make_cfg(t, tasks);
+    return tree_bytes(m, k, n, &cfg)
+         + mm_leaf_packs_bytes(t->leaf, m, k, n, cfg.cutoff, leaf_threads(tasks, threads));
+}
+
+TREE_BF* mm_strassen_tree(MM_ARENA* arena, size_t m, size_t k, size_t n, const MM_ENGINE_TUNING* t, int tasks,
+                          int threads, MM_PACKS* packs){
+    const STRASS_CFG cfg = make_cfg(t, tasks);
+    mm_leaf_packs_init(packs, arena, t->leaf, m, k, n, cfg.cutoff, leaf_threads(tasks, threads));
+    return init_tree(m, k, n, &cfg, arena);
+}
+
+void mm_strassen_run(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                     const MM_ENGINE_TUNING* t, int tasks, int threads, int profile, TREE_BF* tree,
+                     const MM_PACKS* packs){
+    STRASS_CFG cfg = make_cfg(t, tasks);
+    cfg.packs = packs;
+    run(A, F, D, m, k, n, &cfg, threads, profile, tree);
+}
+
+int mm_strassen(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                const MM_ENGINE_TUNING* t, int tasks, int threads) {
+    MM_ENGINE_TUNING resolved = *t;
+    resolved.task_cutoff = mm_strassen_task_cutoff(t, m, k, n, threads);
+    t = &resolved;
+
+    MM_ARENA* arena = mm_arena();
+    size_t mark = arena->top;
+    if (mm_arena_reserve(arena, mm_strassen_bytes(m, k, n, t, tasks, threads), 1)) return -1;
+
+    MM_PACKS packs;
+    TREE_BF* tree = mm_strassen_tree(arena, m, k, n, t, tasks, threads, &packs);
+    mm_strassen_run(A, F, D, m, k, n, t, tasks, threads, 0, tree, &packs);
+
+    mm_arena_pop(arena, mark);
+    return 0;
+}
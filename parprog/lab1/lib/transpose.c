@@ -0,0 +1,128 @@
+#include <immintrin.h>
+
+#include "kernels.h"
+
+void leaf_dot(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+              size_t m, size_t k, size_t n, const MM_PACKS* packs){
+    for(size_t i = 0; i < m; i++){
+        for(size_t j = 0; j < n; j++){
+            uint64_t sum = 0;
+            for(size_t p = 0; p < k; p++){
+                sum += (uint64_t)A[i*lda+p]*F[j*ldf+p];
+            }
+            D[i*ldd+j] = (uint)sum;
+        }
+    }
+}
+
+int mm_transpose(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n){
+    leaf_dot(A, k, F, k, D, n, m, k, n, NULL);
+    return 0;
+}
+
+/*
+ * B^T in TR_BLOCK x TR_BLOCK blocks, so the rows read from B and written
+ * to F stay in cache while a block is done; inside a block, 8 x 8 tiles
+ * are transposed in AVX2 registers.  Blocks are shared across the team.
+ */
+
+#define TR_BLOCK 64
+#define TR_PARALLEL_MIN (256*256)
+
+#ifdef __AVX2__
+static inline void tr_8x8(const uint* src, size_t lds, uint* dst, size_t ldd){
+    __m256i r0 = _mm256_loadu_si256((const __m256i*)(src));
+    __m256i r1 = _mm256_loadu_si256((const __m256i*)(src + lds));
+    __m256i r2 = _mm256_loadu_si256((const __m256i*)(src + 2*lds));
+    __m256i r3 = _mm256_loadu_si256((const __m256i*)(src + 3*lds));
+    __m256i r4 = _mm256_loadu_si256((const __m256i*)(src + 4*lds));
+    __m256i r5 = _mm256_loadu_si256((const __m256i*)(src + 5*lds));
+    __m256i r6 = _mm256_loadu_si256((const __m256i*)(src + 6*lds));
+    __m256i r7 = _mm256_loadu_si256((const __m256i*)(src + 7*lds));
+
+    /* pairs of rows interleaved, then quads, then the 128-bit halves swapped */
+    __m256i t0 = _mm256_unpacklo_epi32(r0, r1), t1 = _mm256_unpackhi_epi32(r0, r1);
+    __m256i t2 = _mm256_unpacklo_epi32(r2, r3), t3 = _mm256_unpackhi_epi32(r2, r3);
+    __m256i t4 = _mm256_unpacklo_epi32(r4, r5), t5 = _mm256_unpackhi_epi32(r4, r5);
+    __m256i t6 = _mm256_unpacklo_epi32(r6, r7), t7 = _mm256_unpackhi_epi32(r6, r7);
+
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2), u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3), u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6), u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7), u7 = _mm256_unpackhi_epi64(t5, t7);
+
+    _mm256_storeu_si256((__m256i*)(dst),         _mm256_permute2x128_si256(u0, u4, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + ldd),   _mm256_permute2x128_si256(u1, u5, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 2*ldd), _mm256_permute2x128_si256(u2, u6, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 3*ldd), _mm256_permute2x128_si256(u3, u7, 0x20));
+    _mm256_storeu_si256((__m256i*)(dst + 4*ldd), _mm256_permute2x128_si256(u0, u4, 0x31));
+    _mm256_storeu_si256((__m256i*)(dst + 5*ldd), _mm256_permute2x128_si256(u1, u5, 0x31));
+    _mm256_storeu_si256((__m256i*)(dst + 6*ldd), _mm256_permute2x128_si256(u2, u6, 0x31));
+    _mm256_storeu_si256((__m256i*)(dst + 7*ldd), _mm256_permute2x128_si256(u3, u7, 0x31));
+}
+#endif
+
+/* F[j0.., i0..] = B[i0.., j0..]^T for one rows x cols block of B. */
+static void tr_block(const uint* B, uint* F, size_t k, size_t n, size_t i0, size_t j0, size_t rows, size_t cols){
+    size_t i = 0;
+#ifdef __AVX2__
+    for(; i + 8 <= rows; i += 8){
+        size_t j = 0;
+        for(; j + 8 <= cols; j += 8) tr_8x8(B + (i0+i)*n + j0 + j, n, F + (j0+j)*k + i0 + i, k);
+        for(; j < cols; j++){
+            for(size_t r = i; r < i + 8; r++) F[(j0+j)*k + i0 + r] = B[(i0+r)*n + j0 + j];
+        }
+    }
+#endif
+    for(; i < rows; i++){
+        for(size_t j = 0; j < cols; j++) F[(j0+j)*k + i0 + i] = B[(i0+i)*n + j0 + j];
+    }
+}
+
+void mm_transpose_B(const uint* B, uint* F, size_t k, size_t n, int threads){
+    size_t bk = (k + TR_BLOCK - 1) / TR_BLOCK, bn = (n + TR_BLOCK - 1) / TR_BLOCK;
+
+    #pragma omp parallel for collapse(2) num_threads(threads > 1 ? threads : 1) if(threads > 1 && k*n >= TR_PARALLEL_MIN) schedule(static)
+    for(size_t bi = 0; bi < bk; bi++){
+        for(size_t bj = 0; bj < bn; bj++){
+            size_t i0 = bi*TR_BLOCK, j0 = bj*TR_BLOCK;
+            tr_block(B, F, k, n, i0, j0, k - i0 < TR_BLOCK ? k - i0 : TR_BLOCK, n - j0 < TR_BLOCK ? n - j0 : TR_BLOCK);
+        }
+    }
+}
+
+/* The same blocking for the other element sizes of the typed kernels, scalar inside a block. */
+#define TR_BLOCK_SCALAR(BITS, T)                                                        \
+static void tr_block_##BITS(const T* B, T* F, size_t k, size_t n, size_t i0, size_t j0, \
+                            size_t rows, size_t cols){                                  \
+    for(size_t j = 0; j < cols; j++){                                                   \
+        for(size_t i = 0; i < rows; i++) F[(j0+j)*k + i0 + i] = B[(i0+i)*n + j0 + j];   \
+    }                                                                                   \
+}
+
+TR_BLOCK_SCALAR(8,  uint8_t)
+TR_BLOCK_SCALAR(16, uint16_t)
+TR_BLOCK_SCALAR(64, uint64_t)
+
+#undef TR_BLOCK_SCALAR
+
+void mm_transpose_elems(const void* B, void* F, size_t k, size_t n, size_t elem, int threads){
+    if (elem == sizeof(uint)) {
+        mm_transpose_B(B, F, k, n, threads);
+        return;
+    }
+    size_t bk = (k + TR_BLOCK - 1) / TR_BLOCK, bn = (n + TR_BLOCK - 1) / TR_BLOCK;
+
+    #pragma omp parallel for collapse(2) num_threads(threads > 1 ? threads : 1) if(threads > 1 && k*n >= TR_PARALLEL_MIN) schedule(static)
+    for(size_t bi = 0; bi < bk; bi++){
+        for(size_t bj = 0; bj < bn; bj++){
+            size_t i0 = bi*TR_BLOCK, j0 = bj*TR_BLOCK;
+            size_t rows = k - i0 < TR_BLOCK ? k - i0 : TR_BLOCK, cols = n - j0 < TR_BLOCK ? n - j0 : TR_BLOCK;
+            switch (elem) {
+            case 1:  tr_block_8(B, F, k, n, i0, j0, rows, cols); break;
+            case 2:  tr_block_16(B, F, k, n, i0, j0, rows, cols); break;
+            default: tr_block_64(B, F, k, n, i0, j0, rows, cols); break;
+            }
+        }
+    }
+}
@@ -0,0 +1,399 @@
+#include <errno.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <omp.h>
+
+#include "kernels.h"
+
+/*
+ * Tuning file: one key=value per line, e.g.
+ *
+ *   host=node17
+ *   threads=16
+ *   block.cutoff=256
+ *   strass.cutoff=256
+ *   strass.leaf=packed
+ *   parallel.task_cutoff=1024
+ *
+ * task_cutoff=never disables tasks for that engine, task_cutoff=depth
+ * derives it from the thread count (MATMUL_TASK_DEPTH).
+ */
+
+#define NEVER ((size_t)-1)
+#define DEPTH MATMUL_TASK_DEPTH
+
+static const MM_TUNING DEFAULTS = {
+    .block_cutoff = 256,
+    .strass   = {256, 512, MATMUL_LEAF_PACKED},
+    .parallel = {256, 512, MATMUL_LEAF_DOT},
+    .simd     = {256, 512, MATMUL_LEAF_AVX2},
+    .winograd = {256, NEVER, MATMUL_LEAF_PACKED},
+};
+
+static const char* LEAF_NAMES[MATMUL_LEAF_COUNT] = {
+    [MATMUL_LEAF_DEFAULT] = "default",
+    [MATMUL_LEAF_DOT]     = "dot",
+    [MATMUL_LEAF_AVX2]    = "avx2",
+    [MATMUL_LEAF_PACKED]  = "packed",
+    [MATMUL_LEAF_FIXED]   = "fixed",
+};
+
+/*
+ * Tunings loaded so far, one per thread count; a process normally runs
+ * with one or two, so past TUNING_SLOTS the last slot is reused.
+ */
+#define TUNING_SLOTS 8
+
+typedef struct TUNING_SLOT {
+    int threads;
+    int tuned;
+    MM_TUNING t;
+} TUNING_SLOT;
+
+static TUNING_SLOT slots[TUNING_SLOTS];
+static int n_slots;
+static pthread_mutex_t tuning_lock = PTHREAD_MUTEX_INITIALIZER;
+
+const char* matmul_leaf_name(MATMUL_LEAF leaf){
+    return leaf < MATMUL_LEAF_COUNT ? LEAF_NAMES[leaf] : NULL;
+}
+
+MATMUL_LEAF matmul_leaf_from_name(const char* name){
+    for (int i = 0; i < MATMUL_LEAF_COUNT; i++) {
+        if (!strcmp(name, LEAF_NAMES[i])) return i;
+    }
+    return MATMUL_LEAF_COUNT;
+}
+
+static void host_name(char* buf, size_t len){
+    if (gethostname(buf, len)) snprintf(buf, len, "localhost");
+    buf[len-1] = '\0';
+}
+
+static int team_size(int threads){
+    return threads > 0 ? threads : omp_get_max_threads();
+}
+
+const char* matmul_tune_path(int threads){
+    static _Thread_local char path[PATH_MAX];
+    threads = team_size(threads);
+
+    const char* env = getenv("MATMUL_TUNE_FILE");
+    if (env && *env) {
+        snprintf(path, sizeof(path), "%s", env);
+        return path;
+    }
+
+    char host[256];
+    host_name(host, sizeof(host));
+
+    const char* cache = getenv("XDG_CACHE_HOME");
+    if (cache && *cache) {
+        snprintf(path, sizeof(path), "%s/matmul/tune-%s-t%d.conf", cache, host, threads);
+    } else {
+        const char* home = getenv("HOME");
+        snprintf(path, sizeof(path), "%s/.cache/matmul/tune-%s-t%d.conf", home ? home : ".", host, threads);
+    }
+    return path;
+}
+
+static MM_ENGINE_TUNING* engine_by_name(MM_TUNING* t, const char* name, size_t len){
+    if (len == 6 && !strncmp(name, "strass", len))   return &t->strass;
+    if (len == 8 && !strncmp(name, "parallel", len)) return &t->parallel;
+    if (len == 4 && !strncmp(name, "simd", len))     return &t->simd;
+    if (len == 8 && !strncmp(name, "winograd", len)) return &t->winograd;
+    return NULL;
+}
+
+static size_t parse_size(const char* value){
+    if (!strcmp(value, "never")) return NEVER;
+    if (!strcmp(value, "depth")) return DEPTH;
+    return strtoull(value, NULL, 10);
+}
+
+/* Returns 0 when the file exists and was written for this host and thread count. */
+static int load(const char* path, int threads, MM_TUNING* t){
+    FILE* file = fopen(path, "r");
+    if (!file) return -1;
+
+    char host[256];
+    host_name(host, sizeof(host));
+    int host_ok = 0, threads_ok = 0;
+
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        line[strcspn(line, "\r\n")] = '\0';
+        char* eq = strchr(line, '=');
+        if (line[0] == '#' || !eq) continue;
+        *eq = '\0';
+        const char* key = line;
+        const char* value = eq + 1;
+
+        if (!strcmp(key, "host")) {
+            host_ok = !strcmp(value, host);
+        } else if (!strcmp(key, "threads")) {
+            threads_ok = atoi(value) == threads;
+        } else if (!strcmp(key, "block.cutoff")) {
+            t->block_cutoff = parse_size(value);
+        } else {
+            const char* dot = strchr(key, '.');
+            MM_ENGINE_TUNING* e = dot ? engine_by_name(t, key, dot - key) : NULL;
+            if (!e) continue;
+            if (!strcmp(dot + 1, "cutoff"))      e->cutoff = parse_size(value);
+            if (!strcmp(dot + 1, "task_cutoff")) e->task_cutoff = parse_size(value);
+            if (!strcmp(dot + 1, "leaf")) {
+                MATMUL_LEAF leaf = matmul_leaf_from_name(value);
+                if (leaf != MATMUL_LEAF_COUNT && leaf != MATMUL_LEAF_DEFAULT) e->leaf = leaf;
+            }
+        }
+    }
+    fclose(file);
+
+    return host_ok && threads_ok ? 0 : -1;
+}
+
+/* The slot for `threads`, loading its tuning file on first use; call with tuning_lock held. */
+static TUNING_SLOT* slot(int threads){
+    for (int i = 0; i < n_slots; i++) {
+        if (slots[i].threads == threads) return &slots[i];
+    }
+    TUNING_SLOT* s = &slots[n_slots < TUNING_SLOTS ? n_slots++ : TUNING_SLOTS - 1];
+    s->threads = threads;
+    s->t = DEFAULTS;
+    s->tuned = !load(matmul_tune_path(threads), threads, &s->t);
+    if (!s->tuned) s->t = DEFAULTS;
+    return s;
+}
+
+void mm_tuning(int threads, MM_TUNING* out){
+    pthread_mutex_lock(&tuning_lock);
+    *out = slot(team_size(threads))->t;
+    pthread_mutex_unlock(&tuning_lock);
+}
+
+int matmul_tuned(int threads){
+    pthread_mutex_lock(&tuning_lock);
+    int tuned = slot(team_size(threads))->tuned;
+    pthread_mutex_unlock(&tuning_lock);
+    return tuned;
+}
+
+static int make_parent_dirs(const char* path){
+    char dir[PATH_MAX];
+    snprintf(dir, sizeof(dir), "%s", path);
+    for (char* p = dir + 1; *p; p++) {
+        if (*p != '/') continue;
+        *p = '\0';
+        if (mkdir(dir, 0755) && errno != EEXIST) return -1;
+        *p = '/';
+    }
+    return 0;
+}
+
+static void write_size(FILE* file, const char* key, size_t value){
+    if (value == NEVER)      fprintf(file, "%s=never\n", key);
+    else if (value == DEPTH) fprintf(file, "%s=depth\n", key);
+    else                     fprintf(file, "%s=%zu\n", key, value);
+}
+
+static int save(const char* path, int threads, const MM_TUNING* t){
+    char tmp[PATH_MAX + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+
+    if (make_parent_dirs(path)) return -1;
+    FILE* file = fopen(tmp, "w");
+    if (!file) return -1;
+
+    char host[256];
+    host_name(host, sizeof(host));
+    fprintf(file, "# libmatmul tuning, written by matmul --autotune\n");
+    fprintf(file, "host=%s\n", host);
+    fprintf(file, "threads=%d\n", threads);
+    write_size(file, "block.cutoff", t->block_cutoff);
+
+    const struct { const char* name; const MM_ENGINE_TUNING* e; } engines[] = {
+        {"strass", &t->strass}, {"parallel", &t->parallel}, {"simd", &t->simd},
+        {"winograd", &t->winograd},
+    };
+    for (size_t i = 0; i < sizeof(engines)/sizeof(engines[0]); i++) {
+        char key[64];
+        snprintf(key, sizeof(key), "%s.cutoff", engines[i].name);
+        write_size(file, key, engines[i].e->cutoff);
+        snprintf(key, sizeof(key), "%s.task_cutoff", engines[i].name);
+        write_size(file, key, engines[i].e->task_cutoff);
+        fprintf(file, "%s.leaf=%s\n", engines[i].name, matmul_leaf_name(engines[i].e->leaf));
+    }
+
+    if (fclose(file) || rename(tmp, path)) {
+        unlink(tmp);
+        return -1;
+    }
+    return 0;
+}
+
+/* ---- sweep ---- */
+
+#define TUNE_REPS 2
+
+typedef struct TUNE_CTX {
+    const uint* A;
+    const uint* F;
+    uint* D;
+    size_t n;
+    int threads;
+} TUNE_CTX;
+
+static double time_leaf(const TUNE_CTX* ctx, MATMUL_LEAF leaf, size_t size){
+    MM_LEAF fn = mm_leaf_fn(leaf);
+    double best = 1e300;
+    for (int r = 0; r < TUNE_REPS; r++) {
+        double t0 = mm_now();
+        fn(ctx->A, ctx->n, ctx->F, ctx->n, ctx->D, ctx->n, size, size, size, NULL);
+        double t = mm_now() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+/* tasks < 0 selects the Winograd engine. */
+static double time_engine(const TUNE_CTX* ctx, const MM_ENGINE_TUNING* e, int tasks){
+    double best = 1e300;
+    for (int r = 0; r < TUNE_REPS; r++) {
+        double t0 = mm_now();
+        int status = tasks < 0 ? mm_winograd(ctx->A, ctx->F, ctx->D, ctx->n, ctx->n, ctx->n, e)
+                               : mm_strassen(ctx->A, ctx->F, ctx->D, ctx->n, ctx->n, ctx->n, e, tasks, ctx->threads);
+        if (status) return 1e300;
+        double t = mm_now() - t0;
+        if (t < best) best = t;
+    }
+    return best;
+}
+
+static double time_block(const TUNE_CTX* ctx, size_t size, size_t cutoff){
+    double t0 = mm_now();
+    mm_block(ctx->A, ctx->F, ctx->D, size, cutoff);
+    return mm_now() - t0;
+}
+
+static const size_t CUTOFFS[] = {64, 128, 256, 512};
+static const size_t TASK_CUTOFFS[] = {256, 512, 1024, 2048, DEPTH, NEVER};
+#define N_CUTOFFS (sizeof(CUTOFFS)/sizeof(CUTOFFS[0]))
+#define N_TASK_CUTOFFS (sizeof(TASK_CUTOFFS)/sizeof(TASK_CUTOFFS[0]))
+
+static void tune_engine(const TUNE_CTX* ctx, const char* name, MM_ENGINE_TUNING* e, int tasks,
+                        const MATMUL_LEAF* best_leaf, FILE* report){
+    double best = 1e300;
+    MM_ENGINE_TUNING cand = *e;
+
+    for (size_t i = 0; i < N_CUTOFFS && CUTOFFS[i] <= ctx->n / 2; i++) {
+        cand.cutoff = CUTOFFS[i];
+        cand.leaf = best_leaf[i];
+        double t = time_engine(ctx, &cand, tasks);
+        if (report) fprintf(report, "[tune] %-8s cutoff=%-4zu leaf=%-6s %.6f s\n",
+                            name, cand.cutoff, matmul_leaf_name(cand.leaf), t);
+        if (t < best) {
+            best = t;
+            *e = cand;
+        }
+    }
+
+    if (tasks <= 0) return;
+
+    cand = *e;
+    for (size_t i = 0; i < N_TASK_CUTOFFS; i++) {
+        size_t c = TASK_CUTOFFS[i];
+        if (c != NEVER && c != DEPTH && (c <= cand.cutoff || c > ctx->n)) continue;
+        cand.task_cutoff = c;
+        double t = time_engine(ctx, &cand, tasks);
+        if (report) {
+            if (c == NEVER)      fprintf(report, "[tune] %-8s task_cutoff=never %.6f s\n", name, t);
+            else if (c == DEPTH) fprintf(report, "[tune] %-8s task_cutoff=depth %.6f s\n", name, t);
+            else fprintf(report, "[tune] %-8s task_cutoff=%-4zu %.6f s\n", name, c, t);
+        }
+        if (t < best) {
+            best = t;
+            *e = cand;
+        }
+    }
+}
+
+int matmul_autotune(size_t n, int threads, FILE* report){
+    if (!n) n = 1024;
+    if (threads <= 0) threads = omp_get_max_threads();
+
+    uint* A = mm_alloc(n*n);
+    uint* F = mm_alloc(n*n);
+    uint* D = mm_alloc(n*n);
+    if (!A || !F || !D) {
+        free(A);
+        free(F);
+        free(D);
+        errno = ENOMEM;
+        return -1;
+    }
+
+    uint32_t x = 2463534242u;
+    for (size_t i = 0; i < n*n; i++) {
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        A[i] = x & 0xff;
+        x ^= x << 13; x ^= x >> 17; x ^= x << 5;
+        F[i] = x & 0xff;
+    }
+
+    TUNE_CTX ctx = {A, F, D, n, threads};
+    MM_TUNING t = DEFAULTS;
+
+    /* Fastest leaf for each candidate cutoff, measured on cutoff^3 blocks. */
+    MATMUL_LEAF best_leaf[N_CUTOFFS];
+    for (size_t i = 0; i < N_CUTOFFS && CUTOFFS[i] <= n / 2; i++) {
+        double best = 1e300;
+        for (int leaf = MATMUL_LEAF_DOT; leaf < MATMUL_LEAF_COUNT; leaf++) {
+            double time = time_leaf(&ctx, leaf, CUTOFFS[i]);
+            if (report) fprintf(report, "[tune] leaf     size=%-6zu leaf=%-6s %.6f s\n",
+                                CUTOFFS[i], matmul_leaf_name(leaf), time);
+            if (time < best) {
+                best = time;
+                best_leaf[i] = leaf;
+            }
+        }
+    }
+
+    tune_engine(&ctx, "strass", &t.strass, 0, best_leaf, report);
+    tune_engine(&ctx, "parallel", &t.parallel, 1, best_leaf, report);
+    tune_engine(&ctx, "simd", &t.simd, 1, best_leaf, report);
+    tune_engine(&ctx, "winograd", &t.winograd, -1, best_leaf, report);
+
+    size_t block_n = n < 512 ? n : 512;
+    double best = 1e300;
+    for (size_t i = 0; i < N_CUTOFFS && CUTOFFS[i] <= block_n; i++) {
+        double time = time_block(&ctx, block_n, CUTOFFS[i]);
+        if (report) fprintf(report, "[tune] block    cutoff=%-4zu %.6f s\n", CUTOFFS[i], time);
+        if (time < best) {
+            best = time;
+            t.block_cutoff = CUTOFFS[i];
+        }
+    }
+
+    free(A);
+    free(F);
+    free(D);
+
+    pthread_mutex_lock(&tuning_lock);
+    TUNING_SLOT* s = slot(threads);
+    s->t = t;
+    s->tuned = 1;
+    pthread_mutex_unlock(&tuning_lock);
+
+    const char* path = matmul_tune_path(threads);
+    if (save(path, threads, &t)) {
+        if (report) fprintf(report, "[tune] failed to write %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    if (report) fprintf(report, "[tune] wrote %s\n", path);
+    return 0;
+}
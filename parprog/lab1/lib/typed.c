@@ -0,0 +1,200 @@
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <immintrin.h>
+#include <omp.h>
+
+#include "kernels.h"
+
+/*
+ * Dtype-generic dot kernels.  Each dtype supplies an AVX2 dot product
+ * (dot_<T>) with a scalar tail; MM_TYPED_KERNEL stamps out the shared
+ * driver that transposes B (cache blocked, mm_transpose_elems) and walks
+ * the rows of C in parallel.
+ *
+ *   u8  x u8  -> u32   zero-extend to 16 bits, vpmaddwd pairs, sum mod 2^32
+ *   i16 x i16 -> i32   vpmaddwd pairs, sum mod 2^32
+ *   i32 x i32 -> i32   vpmulld, sum mod 2^32
+ *   f32 x f32 -> f32   FMA
+ *   f64 x f64 -> f64   FMA
+ */
+
+#ifdef __FMA__
+#define FMADD_PS(a, b, c) _mm256_fmadd_ps(a, b, c)
+#define FMADD_PD(a, b, c) _mm256_fmadd_pd(a, b, c)
+#else
+#define FMADD_PS(a, b, c) _mm256_add_ps(_mm256_mul_ps(a, b), c)
+#define FMADD_PD(a, b, c) _mm256_add_pd(_mm256_mul_pd(a, b), c)
+#endif
+
+static uint32_t hsum_epi32(__m256i v){
+    uint32_t lanes[8];
+    _mm256_storeu_si256((__m256i*)lanes, v);
+    uint32_t sum = 0;
+    for (int i = 0; i < 8; i++) sum += lanes[i];
+    return sum;
+}
+
+static uint32_t dot_u8(const uint8_t* a, const uint8_t* b, size_t k){
+    size_t p = 0;
+    uint32_t sum = 0;
+#ifdef __AVX2__
+    __m256i acc = _mm256_setzero_si256();
+    for (; p + 15 < k; p += 16) {
+        __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(a + p)));
+        __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(b + p)));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+    }
+    sum = hsum_epi32(acc);
+#endif
+    for (; p < k; p++) sum += (uint32_t)a[p] * b[p];
+    return sum;
+}
+
+static int32_t dot_i16(const int16_t* a, const int16_t* b, size_t k){
+    size_t p = 0;
+    uint32_t sum = 0;
+#ifdef __AVX2__
+    __m256i acc = _mm256_setzero_si256();
+    for (; p + 15 < k; p += 16) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + p));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + p));
+        acc = _mm256_add_epi32(acc, _mm256_madd_epi16(x, y));
+    }
+    sum = hsum_epi32(acc);
+#endif
+    for (; p < k; p++) sum += (uint32_t)((int32_t)a[p] * b[p]);
+    return (int32_t)sum;
+}
+
+static int32_t dot_i32(const int32_t* a, const int32_t* b, size_t k){
+    size_t p = 0;
+    uint32_t sum = 0;
+#ifdef __AVX2__
+    __m256i acc = _mm256_setzero_si256();
+    for (; p + 7 < k; p += 8) {
+        __m256i x = _mm256_loadu_si256((const __m256i*)(a + p));
+        __m256i y = _mm256_loadu_si256((const __m256i*)(b + p));
+        acc = _mm256_add_epi32(acc, _mm256_mullo_epi32(x, y));
+    }
+    sum = hsum_epi32(acc);
+#endif
+    for (; p < k; p++) sum += (uint32_t)a[p] * (uint32_t)b[p];
+    return (int32_t)sum;
+}
+
+static float dot_f32(const float* a, const float* b, size_t k){
+    size_t p = 0;
+    float sum = 0;
+#ifdef __AVX2__
+    __m256 acc = _mm256_setzero_ps();
+    for (; p + 7 < k; p += 8) {
+        acc = FMADD_PS(_mm256_loadu_ps(a + p), _mm256_loadu_ps(b + p), acc);
+    }
+    float lanes[8];
+    _mm256_storeu_ps(lanes, acc);
+    for (int i = 0; i < 8; i++) sum += lanes[i];
+#endif
+    for (; p < k; p++) sum += a[p] * b[p];
+    return sum;
+}
+
+static double dot_f64(const double* a, const double* b, size_t k){
+    size_t p = 0;
+    double sum = 0;
+#ifdef __AVX2__
+    __m256d acc = _mm256_setzero_pd();
+    for (; p + 3 < k; p += 4) {
+        acc = FMADD_PD(_mm256_loadu_pd(a + p), _mm256_loadu_pd(b + p), acc);
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, acc);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+    for (; p < k; p++) sum += a[p] * b[p];
+    return sum;
+}
+
+#define MM_TYPED_KERNEL(T, TIN, TOUT)                                                   \
+static int mm_typed_##T(const TIN* A, const TIN* B, TOUT* C,                            \
+                        size_t m, size_t k, size_t n, int threads){                     \
+    TIN* F = aligned_alloc(MM_ALIGN, (n*k*sizeof(TIN) + MM_ALIGN - 1) / MM_ALIGN * MM_ALIGN + MM_ALIGN); \
+    if (!F) return -1;                                                                  \
+    mm_transpose_elems(B, F, k, n, sizeof(TIN), threads);                               \
+    _Pragma("omp parallel for num_threads(threads > 1 ? threads : 1) if(threads > 1) schedule(static)") \
+    for(size_t i = 0; i < m; i++){                                                      \
+        for(size_t j = 0; j < n; j++){                                                  \
+            C[i*n+j] = dot_##T(A + i*k, F + j*k, k);                                    \
+        }                                                                               \
+    }                                                                                   \
+    free(F);                                                                            \
+    return 0;                                                                           \
+}
+
+MM_TYPED_KERNEL(u8,  uint8_t, uint32_t)
+MM_TYPED_KERNEL(i16, int16_t, int32_t)
+MM_TYPED_KERNEL(i32, int32_t, int32_t)
+MM_TYPED_KERNEL(f32, float,   float)
+MM_TYPED_KERNEL(f64, double,  double)
+
+#undef MM_TYPED_KERNEL
+
+static const struct {
+    const char* name;
+    const char* label;
+    MATMUL_DTYPE out;
+} DTYPES[MATMUL_DTYPE_MAX] = {
+    [MATMUL_U32] = {"u32", NULL,           MATMUL_U32},
+    [MATMUL_U64] = {"u64", NULL,           MATMUL_U64},
+    [MATMUL_U8]  = {"u8",  "DOT_U8_U32",   MATMUL_U32},
+    [MATMUL_I16] = {"i16", "DOT_I16_I32",  MATMUL_I32},
+    [MATMUL_I32] = {"i32", "DOT_I32",      MATMUL_I32},
+    [MATMUL_F32] = {"f32", "DOT_F32_FMA",  MATMUL_F32},
+    [MATMUL_F64] = {"f64", "DOT_F64_FMA",  MATMUL_F64},
+};
+
+const char* matmul_dtype_name(MATMUL_DTYPE dtype){
+    return dtype > 0 && dtype < MATMUL_DTYPE_MAX ? DTYPES[dtype].name : NULL;
+}
+
+const char* matmul_dtype_label(MATMUL_DTYPE dtype){
+    return dtype > 0 && dtype < MATMUL_DTYPE_MAX ? DTYPES[dtype].label : NULL;
+}
+
+MATMUL_DTYPE matmul_dtype_from_name(const char* name){
+    for (int i = 1; i < MATMUL_DTYPE_MAX; i++) {
+        if (!strcmp(name, DTYPES[i].name)) return i;
+    }
+    return 0;
+}
+
+MATMUL_DTYPE matmul_dtype_out(MATMUL_DTYPE dtype){
+    return dtype > 0 && dtype < MATMUL_DTYPE_MAX ? DTYPES[dtype].out : 0;
+}
+
+int matmul_typed(const void* A, const void* B, void* C, size_t m, size_t k, size_t n,
+                 MATMUL_DTYPE dtype, MATMUL_ALGO algo, const MATMUL_OPTS* opts){
+    if (dtype == MATMUL_U32) return matmul_mkn(A, B, C, m, k, n, algo, opts);
+    memset(mm_stats(), 0, sizeof(MATMUL_STATS));
+    if (!A || !B || !C || dtype == MATMUL_U64 || !matmul_dtype_out(dtype)) {
+        errno = EINVAL;
+        return -1;
+    }
+    if (!m || !n) return 0;
+
+    int threads = opts && opts->threads > 0 ? opts->threads : omp_get_max_threads();
+    int status = 0;
+    double t = mm_now();
+    switch (dtype) {
+    case MATMUL_U8:  status = mm_typed_u8(A, B, C, m, k, n, threads); break;
+    case MATMUL_I16: status = mm_typed_i16(A, B, C, m, k, n, threads); break;
+    case MATMUL_I32: status = mm_typed_i32(A, B, C, m, k, n, threads); break;
+    case MATMUL_F32: status = mm_typed_f32(A, B, C, m, k, n, threads); break;
+    case MATMUL_F64: status = mm_typed_f64(A, B, C, m, k, n, threads); break;
+    default: break;
+    }
+    mm_phase(MATMUL_PHASE_COMPUTE, t);
+
+    if (status) errno = ENOMEM;
+    return status;
+}
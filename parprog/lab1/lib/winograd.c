@@ -0,0 +1,129 @@
+#include "kernels.h"
+
+/*
+ * Strassen-Winograd with the two-temporary schedule of Douglas et al.:
+ *
+ *   S1 = A21 + A22   T1 = B12 - B11   P1 = A11 B11   P5 = S1 T1
+ *   S2 = S1 - A11    T2 = B22 - T1    P2 = A12 B21   P6 = S2 T2
+ *   S3 = A11 - A21   T3 = B22 - B12   P3 = S4 B22    P7 = S3 T3
+ *   S4 = A12 - S2    T4 = T2 - B21    P4 = A22 T4
+ *
+ *   C11 = P1 + P2          U2 = P1 + P6     C21 = U3 - P4
+ *   C12 = U2 + P5 + P3     U3 = U2 + P7     C22 = U3 + P5
+ *
+ * X holds the S operands and then P1, Y holds the T operands; every other
+ * product goes straight into a quadrant of D.  The recursion is sequential,
+ * so every level's X and Y come from one arena block.  B is only ever seen
+ * as F = B^T, so Bij lives in the F block BTji.
+ */
+
+static size_t min3(size_t a, size_t b, size_t c){
+    size_t r = a < b ? a : b;
+    return r < c ? r : c;
+}
+
+/* Z = X + sign*Y over a rows x cols block; Z may alias X or Y. */
+static void add(const uint* X, size_t ldx, const uint* Y, size_t ldy, uint* Z, size_t ldz,
+                size_t rows, size_t cols, int sign){
+    for(size_t i = 0; i < rows; i++){
+        const uint* x = X + i*ldx;
+        const uint* y = Y + i*ldy;
+        uint* z = Z + i*ldz;
+        if (sign > 0) for(size_t j = 0; j < cols; j++) z[j] = x[j] + y[j];
+        else          for(size_t j = 0; j < cols; j++) z[j] = x[j] - y[j];
+    }
+}
+
+static size_t level_len(size_t m2, size_t k2, size_t n2){
+    return m2 * (k2 > n2 ? k2 : n2) + n2 * k2;
+}
+
+static size_t workspace_len(size_t m, size_t k, size_t n, size_t cutoff){
+    size_t len = 0;
+    while (min3(m, k, n) > cutoff) {
+        m /= 2; k /= 2; n /= 2;
+        len += level_len(m, k, n);
+    }
+    return len;
+}
+
+static void winograd(const uint* A, size_t lda, const uint* F, size_t ldf, uint* D, size_t ldd,
+                     size_t m, size_t k, size_t n, uint* W, MM_LEAF leaf, const MM_PACKS* packs, size_t cutoff){
+    if (min3(m, k, n) <= cutoff) {
+        leaf(A, lda, F, ldf, D, ldd, m, k, n, packs);
+        return;
+    }
+
+    size_t m2 = m / 2, k2 = k / 2, n2 = n / 2;
+
+    const uint* A11 = A;
+    const uint* A12 = A + k2;
+    const uint* A21 = A + m2 * lda;
+    const uint* A22 = A + m2 * lda + k2;
+
+    const uint* B11 = F;
+    const uint* B21 = F + k2;
+    const uint* B12 = F + n2 * ldf;
+    const uint* B22 = F + n2 * ldf + k2;
+
+    uint* C11 = D;
+    uint* C12 = D + n2;
+    uint* C21 = D + m2 * ldd;
+    uint* C22 = D + m2 * ldd + n2;
+
+    uint* X = W;
+    uint* Y = W + m2 * (k2 > n2 ? k2 : n2);
+    uint* next = W + level_len(m2, k2, n2);
+
+    add(A11, lda, A21, lda, X, k2, m2, k2, -1);                                    /* S3 */
+    add(B22, ldf, B12, ldf, Y, k2, n2, k2, -1);                                    /* T3 */
+    winograd(X, k2, Y, k2, C21, ldd, m2, k2, n2, next, leaf, packs, cutoff);       /* P7 */
+    add(A21, lda, A22, lda, X, k2, m2, k2, 1);                                     /* S1 */
+    add(B12, ldf, B11, ldf, Y, k2, n2, k2, -1);                                    /* T1 */
+    winograd(X, k2, Y, k2, C22, ldd, m2, k2, n2, next, leaf, packs, cutoff);       /* P5 */
+    add(X, k2, A11, lda, X, k2, m2, k2, -1);                                       /* S2 */
+    add(B22, ldf, Y, k2, Y, k2, n2, k2, -1);                                       /* T2 */
+    winograd(X, k2, Y, k2, C12, ldd, m2, k2, n2, next, leaf, packs, cutoff);       /* P6 */
+    add(A12, lda, X, k2, X, k2, m2, k2, -1);                                       /* S4 */
+    winograd(X, k2, B22, ldf, C11, ldd, m2, k2, n2, next, leaf, packs, cutoff);    /* P3 */
+    winograd(A11, lda, B11, ldf, X, n2, m2, k2, n2, next, leaf, packs, cutoff);    /* P1 */
+    add(X, n2, C12, ldd, C12, ldd, m2, n2, 1);                                     /* U2 = P1 + P6 */
+    add(C12, ldd, C21, ldd, C21, ldd, m2, n2, 1);                                  /* U3 = U2 + P7 */
+    add(C12, ldd, C22, ldd, C12, ldd, m2, n2, 1);                                  /* U4 = U2 + P5 */
+    add(C21, ldd, C22, ldd, C22, ldd, m2, n2, 1);                                  /* U7 = U3 + P5 */
+    add(C12, ldd, C11, ldd, C12, ldd, m2, n2, 1);                                  /* U5 = U4 + P3 */
+    add(Y, k2, B21, ldf, Y, k2, n2, k2, -1);                                       /* T4 */
+    winograd(A22, lda, Y, k2, C11, ldd, m2, k2, n2, next, leaf, packs, cutoff);    /* P4 */
+    add(C21, ldd, C11, ldd, C21, ldd, m2, n2, -1);                                 /* U6 = U3 - P4 */
+    winograd(A12, lda, B21, ldf, C11, ldd, m2, k2, n2, next, leaf, packs, cutoff); /* P2 */
+    add(X, n2, C11, ldd, C11, ldd, m2, n2, 1);                                     /* U1 = P1 + P2 */
+
+    mm_strassen_peel(A, lda, F, ldf, D, ldd, m, k, n, leaf, packs);
+}
+
+size_t mm_winograd_bytes(size_t m, size_t k, size_t n, const MM_ENGINE_TUNING* t){
+    return workspace_len(m, k, n, t->cutoff ? t->cutoff : 1) * sizeof(uint);
+}
+
+void mm_winograd_run(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                     const MM_ENGINE_TUNING* t, uint* W, const MM_PACKS* packs){
+    winograd(A, k, F, k, D, n, m, k, n, W, mm_leaf_fn(t->leaf), packs, t->cutoff ? t->cutoff : 1);
+}
+
+int mm_winograd(const uint* A, const uint* F, uint* D, size_t m, size_t k, size_t n,
+                const MM_ENGINE_TUNING* t){
+    size_t bytes = mm_winograd_bytes(m, k, n, t);
+    size_t cutoff = t->cutoff ? t->cutoff : 1;
+
+    MM_ARENA* arena = mm_arena();
+    size_t mark = arena->top;
+    if (mm_arena_reserve(arena, MM_ARENA_LEN(bytes) + mm_leaf_packs_bytes(t->leaf, m, k, n, cutoff, 1), 1)) return -1;
+
+    MM_PACKS packs;
+    uint* W = mm_arena_push(arena, bytes);
+    mm_leaf_packs_init(&packs, arena, t->leaf, m, k, n, cutoff, 1);
+    mm_winograd_run(A, F, D, m, k, n, t, W, &packs);
+
+    mm_arena_pop(arena, mark);
+    return 0;
+}
@@ -0,0 +1,74 @@
+"""Read/write helpers for lab1 matrix files (text .dat and binary .bin)."""
+import struct
+from pathlib import Path
+
+import numpy as np
+
+MAGIC = b"MATB"
+VERSION = 1
+HEADER_SIZE = 64
+ALIGNMENT = 64
+DTYPES = {1: np.uint32, 2: np.uint64, 3: np.uint8, 4: np.int16, 5: np.int32, 6: np.float32, 7: np.float64}
+DTYPE_CODES = {np.dtype(v): k for k, v in DTYPES.items()}
+
+# magic, version, dtype, header_size, alignment, rows, cols, stride, count, reserved
+HEADER = struct.Struct("<4sHHIIQQQQ16x")
+
+
+def is_binary_path(path) -> bool:
+    return Path(path).suffix == ".bin"
+
+
+def read_matrix(path) -> np.ndarray:
+    """Returns the matrix stored in `path`; binary files come back memory-mapped.
+
+    Batch files come back as a (count, rows, cols) array.
+    """
+    path = Path(path)
+    with path.open("rb") as f:
+        head = f.read(HEADER.size)
+
+    if head[:4] != MAGIC:
+        with path.open() as f:
+            size = int(f.readline())
+            # Parsed by numpy in C rather than one int() per token.
+            flat = np.fromstring(f.read(), dtype=np.uint64, sep=" ")
+        return flat[: size * size].astype(np.uint32).reshape(size, size)
+
+    _, version, dtype, header_size, _, rows, cols, stride, count = HEADER.unpack(head)
+    if version != VERSION or dtype not in DTYPES:
+        raise ValueError(f"{path}: unsupported matrix header (version {version}, dtype {dtype})")
+    if count > 1:
+        data = np.memmap(path, dtype=DTYPES[dtype], mode="r", offset=header_size, shape=(count, rows, stride))
+        return data[:, :, :cols]
+    data = np.memmap(path, dtype=DTYPES[dtype], mode="r", offset=header_size, shape=(rows, stride))
+    return data[:, :cols]
+
+
+def write_matrix(path, matrix: np.ndarray) -> None:
+    """Writes `matrix` as binary if `path` ends with .bin, as text otherwise.
+
+    A 3-D array is written as a binary batch of matrix.shape[0] matrices.
+    """
+    path = Path(path)
+    if is_binary_path(path):
+        dtype = matrix.dtype if matrix.dtype in DTYPE_CODES else np.uint32
+        matrix = np.ascontiguousarray(matrix, dtype=dtype)
+        count, rows, cols = matrix.shape if matrix.ndim == 3 else (1, *matrix.shape)
+        with path.open("wb") as f:
+            f.write(HEADER.pack(MAGIC, VERSION, DTYPE_CODES[matrix.dtype], HEADER_SIZE, ALIGNMENT, rows, cols, cols, count))
+            matrix.tofile(f)
+        return
+
+    if matrix.ndim != 2:
+        raise ValueError(f"{path}: batches can only be written as .bin")
+    flat = matrix.ravel()
+    if not np.issubdtype(flat.dtype, np.integer):
+        flat = flat.astype(np.int64)
+    with path.open("w") as f:
+        f.write(f"{matrix.shape[0]}\n")
+        # Write in chunks to avoid holding a giant string in memory for large matrices;
+        # tolist() converts a whole chunk to Python ints at once.
+        for start in range(0, flat.size, 1 << 16):
+            f.write(" ".join(map(str, flat[start : start + (1 << 16)].tolist())))
+            f.write(" ")
@@ -0,0 +1,605 @@
+#include <getopt.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <omp.h>
+
+#include "matio.h"
+#include "matmul.h"
+
+/* CLOCK_MONOTONIC seconds; TIME_UTC can step under NTP mid-measurement. */
+static double now(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec*1e-9;
+}
+
+/* Summary of the timed repetitions of one run. */
+typedef struct TIMING {
+    int reps;
+    double median, p10, p90, mean, stddev;
+} TIMING;
+
+static int cmp_double(const void* a, const void* b){
+    double x = *(const double*)a, y = *(const double*)b;
+    return (x > y) - (x < y);
+}
+
+/* q-quantile of n sorted samples, interpolated between neighbours. */
+static double quantile(const double* s, int n, double q){
+    double x = q * (n - 1);
+    int i = (int)x;
+    return i + 1 < n ? s[i] + (s[i+1] - s[i]) * (x - i) : s[i];
+}
+
+static TIMING summarize(double* samples, int n){
+    TIMING t = {.reps = n};
+    qsort(samples, n, sizeof(double), cmp_double);
+    t.median = quantile(samples, n, 0.5);
+    t.p10 = quantile(samples, n, 0.1);
+    t.p90 = quantile(samples, n, 0.9);
+    for (int i = 0; i < n; i++) t.mean += samples[i] / n;
+    for (int i = 0; i < n; i++) t.stddev += (samples[i] - t.mean) * (samples[i] - t.mean);
+    t.stddev = n > 1 ? sqrt(t.stddev / (n - 1)) : 0;
+    return t;
+}
+
+static void usage(const char* prog){
+    fprintf(stderr, "Usage: %s [--algo=NAME] [--threads=N] [--cutoff=N] [--task-cutoff=N|depth] [--leaf=NAME]\n"
+                    "       [--overflow=MODE] [--no-autotune] [--thread-report] [--numa] [--warmup=N] [--reps=N] [--perf]\n"
+                    "       [--phases=FILE.csv|FILE.json]\n"
+                    "       <A.dat|A.bin> <B.dat|B.bin> <output.dat|output.bin> <logfile>\n"
+                    "       (batch .bin inputs run every A[i] * B[i] product, see matmul_batch)\n"
+                    "       %s --mem-budget=SIZE[K|M|G] [--algo=NAME] [--threads=N] ... <A.bin> <B.bin> <output.bin> <logfile>\n"
+                    "       (out-of-core: streams u32 inputs in tiles, see matmul_ooc)\n"
+                    "       %s --autotune [--tune-size=N] [--threads=N]\n", prog, prog, prog);
+    fprintf(stderr, "Algorithms:");
+    for (int i = 0; i < MATMUL_ALGO_COUNT; i++) fprintf(stderr, " %s", matmul_algo_name(i));
+    fprintf(stderr, "\nLeaves:");
+    for (int i = MATMUL_LEAF_DOT; i < MATMUL_LEAF_COUNT; i++) fprintf(stderr, " %s", matmul_leaf_name(i));
+    fprintf(stderr, "\nOverflow modes:");
+    for (int i = 0; i < MATMUL_OVERFLOW_COUNT; i++) fprintf(stderr, " %s", matmul_overflow_name(i));
+    fprintf(stderr, "\nTuning file: %s\n", matmul_tune_path(0));
+}
+
+/*
+ * libgomp reads OMP_PLACES / OMP_PROC_BIND once at startup, so --numa sets
+ * them (unless the user already did) and re-executes the binary.
+ */
+static void pin_threads(char** argv){
+    if (getenv("OMP_PLACES") || getenv("OMP_PROC_BIND")) return;
+    setenv("OMP_PLACES", "cores", 1);
+    setenv("OMP_PROC_BIND", "spread", 1);
+    execv("/proc/self/exe", argv);
+    perror("Failed to re-exec with OMP_PLACES set, running unpinned");
+}
+
+/* "512M", "8G", ... in bytes (powers of 1024); 0 if unparsable. */
+static size_t parse_size(const char* s){
+    char* end;
+    size_t v = strtoull(s, &end, 10);
+    switch (*end) {
+    case 'K': case 'k': return end[1] ? 0 : v << 10;
+    case 'M': case 'm': return end[1] ? 0 : v << 20;
+    case 'G': case 'g': return end[1] ? 0 : v << 30;
+    case 'T': case 't': return end[1] ? 0 : v << 40;
+    case '\0':          return v;
+    default:            return 0;
+    }
+}
+
+/*
+ * --mem-budget: C = A * B straight between files, never holding a whole
+ * matrix in memory.  Only the headers are read here, for the checks and
+ * the log line.
+ */
+static int run_out_of_core(char** args, MATMUL_ALGO algo, const MATMUL_OPTS* opts, size_t budget){
+    MAT_HEADER hA, hB;
+    if (mat_read_header(args[0], &hA) || mat_read_header(args[1], &hB)) {
+        fprintf(stderr, "Out-of-core mode needs binary (%s) inputs\n", MAT_BIN_EXT);
+        return 1;
+    }
+    if (hA.dtype != MAT_U32 || hB.dtype != MAT_U32 || hA.count > 1 || hB.count > 1) {
+        fprintf(stderr, "Out-of-core mode needs single u32 matrices (A is %s, B is %s)\n",
+                matmul_dtype_name(hA.dtype), matmul_dtype_name(hB.dtype));
+        return 1;
+    }
+    if (hA.cols != hB.rows) {
+        fprintf(stderr, "Matrix size mismatch: A=%zux%zu B=%zux%zu\n",
+                (size_t)hA.rows, (size_t)hA.cols, (size_t)hB.rows, (size_t)hB.cols);
+        return 1;
+    }
+    size_t len = strlen(args[2]), ext = strlen(MAT_BIN_EXT);
+    if (len < ext || strcmp(args[2] + len - ext, MAT_BIN_EXT)) {
+        fprintf(stderr, "Out-of-core output must be a %s file\n", MAT_BIN_EXT);
+        return 1;
+    }
+
+    double start = now();
+    if (matmul_ooc(args[0], args[1], args[2], budget, algo, opts)) {
+        perror("Out-of-core matmul failed");
+        return 1;
+    }
+    double elapsed = now() - start;
+
+    MATMUL_STATS st;
+    matmul_get_stats(&st);
+    fprintf(stderr, "[ooc] %.1f MiB resident, loader %.3f s, compute waited %.3f s\n",
+            st.workspace_bytes / 1048576.0, st.io_seconds, st.io_wait_seconds);
+
+    FILE* file_LOG = fopen(args[3], "a");
+    if (!file_LOG) {
+        perror("Failed to open log file");
+        return 0;
+    }
+    size_t m = hA.rows, k = hA.cols, n = hB.cols;
+    if (m == k && k == n)
+        fprintf(file_LOG, "OOC_%s,%zu,%.9lf,%.9lf,%.9lf\n", matmul_algo_label(algo), n, elapsed,
+                st.alloc_seconds, st.touch_seconds);
+    else
+        fprintf(file_LOG, "OOC_%s,%zux%zux%zu,%.9lf,%.9lf,%.9lf\n", matmul_algo_label(algo), m, k, n, elapsed,
+                st.alloc_seconds, st.touch_seconds);
+    fclose(file_LOG);
+    return 0;
+}
+
+static void print_thread_report(const MATMUL_STATS* st){
+    if (!st->team_threads) {
+        fprintf(stderr, "No tasked Strassen run (parallel / simd with tasks enabled), nothing to report\n");
+        return;
+    }
+
+    int threads = st->team_threads < MATMUL_STATS_THREADS ? st->team_threads : MATMUL_STATS_THREADS;
+    double total = 0, lo = st->team_seconds, hi = 0;
+    fprintf(stderr, "thread      busy_s      idle_s  busy%%\n");
+    for (int i = 0; i < threads; i++) {
+        double busy = st->busy_seconds[i];
+        fprintf(stderr, "%6d %11.6f %11.6f %5.1f\n", i, busy, st->team_seconds - busy,
+                st->team_seconds > 0 ? 100 * busy / st->team_seconds : 0);
+        total += busy;
+        if (busy < lo) lo = busy;
+        if (busy > hi) hi = busy;
+    }
+    fprintf(stderr, "team %d threads, %.6f s wall, %.1f%% busy, busiest/idlest %.6f/%.6f s\n",
+            st->team_threads, st->team_seconds,
+            st->team_seconds > 0 ? 100 * total / (threads * st->team_seconds) : 0, hi, lo);
+}
+
+/* Per-call counts: totals over the timed reps divided by their number. */
+static double per_call(uint64_t v, int reps){
+    return v == MATMUL_PERF_NA ? -1 : (double)v / reps;
+}
+
+static void print_counter(FILE* out, uint64_t v, int reps){
+    if (v == MATMUL_PERF_NA) fprintf(out, " %14s", "n/a");
+    else fprintf(out, " %14.0f", per_call(v, reps));
+}
+
+static void print_perf_report(const MATMUL_PERF_COUNTS* pc, int reps){
+    fprintf(stderr, "[perf] per call, %d threads:\n[perf] thread", pc->threads);
+    for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) fprintf(stderr, " %14s", matmul_perf_event_name(e));
+    fprintf(stderr, "    ipc\n");
+    for (int t = 0; t <= pc->threads; t++) {
+        const uint64_t* v = t < pc->threads ? pc->thread[t] : pc->total;
+        if (t < pc->threads) fprintf(stderr, "[perf] %6d", t);
+        else fprintf(stderr, "[perf]  total");
+        for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) print_counter(stderr, v[e], reps);
+        uint64_t cyc = v[MATMUL_PERF_CYCLES], ins = v[MATMUL_PERF_INSTRUCTIONS];
+        if (cyc && cyc != MATMUL_PERF_NA && ins != MATMUL_PERF_NA) fprintf(stderr, " %6.3f\n", (double)ins / cyc);
+        else fprintf(stderr, " %6s\n", "n/a");
+    }
+}
+
+/*
+ * --phases: where one run's time goes.  load and write are measured once,
+ * the library phases (MATMUL_STATS) are averaged over the timed reps.
+ */
+typedef struct PHASES {
+    double load, write;
+    MATMUL_STATS call;
+} PHASES;
+
+static void add_call_phases(PHASES* ph, const MATMUL_STATS* st){
+    ph->call.alloc_seconds += st->alloc_seconds;
+    ph->call.touch_seconds += st->touch_seconds;
+    for (int p = 0; p < MATMUL_PHASE_COUNT; p++) ph->call.phase_seconds[p] += st->phase_seconds[p];
+    for (int l = 0; l < st->levels; l++) ph->call.level_seconds[l] += st->level_seconds[l];
+    if (st->levels > ph->call.levels) ph->call.levels = st->levels;
+}
+
+/*
+ * Appends the phases to `path`: one JSON object per line for *.json, else
+ * label,size,phase,seconds rows (strass levels as level0, level1, ...).
+ * alloc and touch are split out of setup so that the phases add up.
+ */
+static int write_phases(const char* path, const char* label, const char* size, int reps, const PHASES* ph){
+    FILE* f = fopen(path, "a");
+    if (!f) return -1;
+
+    const MATMUL_STATS* c = &ph->call;
+    double setup = (c->phase_seconds[MATMUL_PHASE_SETUP] - c->alloc_seconds - c->touch_seconds) / reps;
+    const struct { const char* name; double seconds; } rows[] = {
+        {"load", ph->load},
+        {"alloc", c->alloc_seconds / reps},
+        {"touch", c->touch_seconds / reps},
+        {"setup", setup > 0 ? setup : 0},
+        {matmul_phase_name(MATMUL_PHASE_TRANSPOSE), c->phase_seconds[MATMUL_PHASE_TRANSPOSE] / reps},
+        {matmul_phase_name(MATMUL_PHASE_COMPUTE), c->phase_seconds[MATMUL_PHASE_COMPUTE] / reps},
+        {matmul_phase_name(MATMUL_PHASE_COMBINE), c->phase_seconds[MATMUL_PHASE_COMBINE] / reps},
+        {"write", ph->write},
+    };
+    int count = sizeof(rows) / sizeof(rows[0]);
+
+    const char* ext = strrchr(path, '.');
+    if (ext && !strcmp(ext, ".json")) {
+        fprintf(f, "{\"label\":\"%s\",\"size\":\"%s\",\"reps\":%d,\"phases\":{", label, size, reps);
+        for (int i = 0; i < count; i++) fprintf(f, "%s\"%s\":%.9f", i ? "," : "", rows[i].name, rows[i].seconds);
+        fprintf(f, "},\"levels\":[");
+        for (int l = 0; l < c->levels; l++) fprintf(f, "%s%.9f", l ? "," : "", c->level_seconds[l] / reps);
+        fprintf(f, "]}\n");
+    } else {
+        fseek(f, 0, SEEK_END);
+        if (ftell(f) == 0) fprintf(f, "label,size,phase,seconds\n");
+        for (int i = 0; i < count; i++) fprintf(f, "%s,%s,%s,%.9f\n", label, size, rows[i].name, rows[i].seconds);
+        for (int l = 0; l < c->levels; l++) fprintf(f, "%s,%s,level%d,%.9f\n", label, size, l, c->level_seconds[l] / reps);
+    }
+    return fclose(f) ? -1 : 0;
+}
+
+int main(int argc, char** argv){
+    static const struct option long_opts[] = {
+        {"algo",    required_argument, NULL, 'a'},
+        {"threads", required_argument, NULL, 't'},
+        {"cutoff",      required_argument, NULL, 'c'},
+        {"task-cutoff", required_argument, NULL, 'T'},
+        {"leaf",        required_argument, NULL, 'l'},
+        {"autotune",    no_argument,       NULL, 'A'},
+        {"tune-size",   required_argument, NULL, 's'},
+        {"no-autotune", no_argument,       NULL, 'N'},
+        {"overflow",    required_argument, NULL, 'o'},
+        {"thread-report", no_argument,     NULL, 'R'},
+        {"numa",        no_argument,       NULL, 'U'},
+        {"mem-budget",  required_argument, NULL, 'M'},
+        {"warmup",      required_argument, NULL, 'w'},
+        {"reps",        required_argument, NULL, 'r'},
+        {"perf",        no_argument,       NULL, 'P'},
+        {"phases",      required_argument, NULL, 'F'},
+        {"help",    no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    MATMUL_ALGO algo = MATMUL_PACKED;
+    MATMUL_OPTS opts = {0};
+    MATMUL_OVERFLOW overflow = MATMUL_WRAP;
+    int autotune = 0, no_autotune = 0, thread_report = 0;
+    size_t tune_size = 0, budget = 0;
+    int warmup = 0, reps = 1, perf_counters = 0;
+    const char* phases_path = NULL;
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "a:t:c:T:l:h", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'a':
+            algo = matmul_algo_from_name(optarg);
+            if (algo == MATMUL_ALGO_COUNT) {
+                fprintf(stderr, "Unknown algorithm: %s\n", optarg);
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 't':
+            opts.threads = atoi(optarg);
+            break;
+        case 'c':
+            opts.cutoff = strtoull(optarg, NULL, 10);
+            break;
+        case 'T':
+            opts.task_cutoff = strcmp(optarg, "depth") ? strtoull(optarg, NULL, 10) : MATMUL_TASK_DEPTH;
+            break;
+        case 'l':
+            opts.leaf = matmul_leaf_from_name(optarg);
+            if (opts.leaf == MATMUL_LEAF_COUNT) {
+                fprintf(stderr, "Unknown leaf: %s\n", optarg);
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'A':
+            autotune = 1;
+            break;
+        case 's':
+            tune_size = strtoull(optarg, NULL, 10);
+            break;
+        case 'N':
+            no_autotune = 1;
+            break;
+        case 'R':
+            thread_report = 1;
+            break;
+        case 'U':
+            opts.numa = 1;
+            break;
+        case 'w':
+            warmup = atoi(optarg);
+            if (warmup < 0) warmup = 0;
+            break;
+        case 'r':
+            reps = atoi(optarg);
+            if (reps < 1) reps = 1;
+            break;
+        case 'P':
+            perf_counters = 1;
+            break;
+        case 'F':
+            phases_path = optarg;
+            opts.profile = 1;
+            break;
+        case 'M':
+            budget = parse_size(optarg);
+            if (!budget) {
+                fprintf(stderr, "Bad memory budget: %s\n", optarg);
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        case 'o':
+            overflow = matmul_overflow_from_name(optarg);
+            if (overflow == MATMUL_OVERFLOW_COUNT) {
+                fprintf(stderr, "Unknown overflow mode: %s\n", optarg);
+                usage(argv[0]);
+                return 1;
+            }
+            break;
+        default:
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (opts.numa) {
+        pin_threads(argv);
+    }
+
+    if (autotune && argc == optind) {
+        return matmul_autotune(tune_size, opts.threads, stderr) ? 1 : 0;
+    }
+
+    if (argc - optind < 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    char** args = argv + optind;
+
+    if (budget) {
+        if (overflow != MATMUL_WRAP) {
+            fprintf(stderr, "--mem-budget only supports wrapping overflow\n");
+            return 1;
+        }
+        if (warmup || reps > 1 || perf_counters || phases_path) {
+            fprintf(stderr, "--mem-budget runs once: --warmup, --reps, --perf and --phases don't apply\n");
+            return 1;
+        }
+        return run_out_of_core(args, algo, &opts, budget);
+    }
+
+    MAT_FILE mat_A, mat_B, mat_D;
+    int status = 0;
+    PHASES phases = {0};
+
+    double load_start = now();
+    if (mat_load(args[0], &mat_A)) {
+        return 1;
+    }
+    if (mat_load(args[1], &mat_B)) {
+        mat_close(&mat_A);
+        return 1;
+    }
+    phases.load = now() - load_start;
+
+    if (mat_A.dtype != mat_B.dtype) {
+        fprintf(stderr, "Matrix dtype mismatch: A is %s, B is %s\n",
+                matmul_dtype_name(mat_A.dtype), matmul_dtype_name(mat_B.dtype));
+        mat_close(&mat_A);
+        mat_close(&mat_B);
+        return 1;
+    }
+    MATMUL_DTYPE dtype = mat_A.dtype;
+    if (dtype != MATMUL_U32 && overflow != MATMUL_WRAP) {
+        fprintf(stderr, "--overflow only applies to u32 inputs\n");
+        mat_close(&mat_A);
+        mat_close(&mat_B);
+        return 1;
+    }
+
+    if (mat_A.cols != mat_B.rows) {
+        fprintf(stderr, "Matrix size mismatch: A=%zux%zu B=%zux%zu\n", mat_A.rows, mat_A.cols, mat_B.rows, mat_B.cols);
+        mat_close(&mat_A);
+        mat_close(&mat_B);
+        return 1;
+    }
+
+    size_t m = mat_A.rows, k = mat_A.cols, n = mat_B.cols;
+    size_t count = mat_A.count;
+    int batch = mat_A.count > 1 || mat_B.count > 1;
+    if (batch && (mat_A.count != mat_B.count || dtype != MATMUL_U32 || overflow != MATMUL_WRAP)) {
+        fprintf(stderr, "Batches need u32 inputs with the same count (A has %zu, B has %zu) and wrapping overflow\n",
+                mat_A.count, mat_B.count);
+        mat_close(&mat_A);
+        mat_close(&mat_B);
+        return 1;
+    }
+
+    int tunable = algo == MATMUL_BLOCK || algo == MATMUL_STRASSEN || algo == MATMUL_PARALLEL || algo == MATMUL_SIMD
+                || algo == MATMUL_WINOGRAD || algo == MATMUL_MORTON;
+    if (autotune || (tunable && !batch && dtype == MATMUL_U32 && overflow == MATMUL_WRAP && !no_autotune && !matmul_tuned(opts.threads))) {
+        if (!autotune) fprintf(stderr, "No tuning for this machine yet, running autotune (--no-autotune to skip)\n");
+        if (matmul_autotune(tune_size, opts.threads, autotune ? stderr : NULL)) {
+            fprintf(stderr, "Autotune failed, using built-in defaults\n");
+        }
+    }
+
+    int out_dtype = overflow == MATMUL_EXACT64 ? MAT_U64 : matmul_dtype_out(dtype);
+    if (mat_create_batch(args[2], count, m, n, out_dtype, &mat_D)) {
+        mat_close(&mat_A);
+        mat_close(&mat_B);
+        return 1;
+    }
+
+    /* --numa: compute on copies first-touched by the team instead of the I/O thread's pages */
+    const void* a = mat_A.data;
+    const void* b = mat_B.data;
+    void* d = mat_D.data;
+    size_t a_bytes = count*m*k*mat_dtype_size(dtype);
+    size_t b_bytes = count*k*n*mat_dtype_size(dtype);
+    size_t d_bytes = count*m*n*mat_dtype_size(out_dtype);
+    if (opts.numa) {
+        int team = opts.threads > 0 ? opts.threads : omp_get_max_threads();
+        void* na = matmul_numa_dup(a, a_bytes, team);
+        void* nb = matmul_numa_dup(b, b_bytes, team);
+        void* nd = matmul_numa_alloc(d_bytes, team);
+        if (na && nb && nd) {
+            a = na;
+            b = nb;
+            d = nd;
+        } else {
+            perror("NUMA buffers failed, using the loaded matrices");
+            matmul_numa_free(na, a_bytes);
+            matmul_numa_free(nb, b_bytes);
+            matmul_numa_free(nd, d_bytes);
+        }
+    }
+
+    /* --warmup untimed calls, then --reps timed ones; the log gets the median. */
+    double* samples = malloc(reps * sizeof(double));
+    if (!samples) {
+        perror("Failed to allocate timing samples");
+        status = 1;
+    }
+    /* --perf counts the timed reps only, on the thread team the kernels use. */
+    MATMUL_PERF* perf = NULL;
+    MATMUL_PERF_COUNTS counts;
+    if (perf_counters && !status) {
+        perf = matmul_perf_open(opts.threads);
+        if (!perf) perror("Hardware counters unavailable");
+    }
+    int counting = 0;
+    for (int it = 0; !status && it < warmup + reps; it++) {
+        if (perf && it == warmup) {
+            matmul_perf_start(perf);
+            counting = 1;
+        }
+        double start = now();
+        int failed = batch ? matmul_batch(a, b, d, count, m, k, n, &opts)
+            : dtype == MATMUL_U32
+            ? matmul_overflow(a, b, d, m, k, n, algo, overflow, &opts)
+            : matmul_typed(a, b, d, m, k, n, dtype, algo, &opts);
+        double elapsed = now() - start;
+        if (failed) {
+            perror("matmul failed");
+            status = 1;
+        } else if (it >= warmup) {
+            samples[it - warmup] = elapsed;
+            if (phases_path) {
+                MATMUL_STATS st;
+                matmul_get_stats(&st);
+                add_call_phases(&phases, &st);
+            }
+        }
+    }
+    TIMING timing = status ? (TIMING){0} : summarize(samples, reps);
+    free(samples);
+    int have_counts = counting && !status;
+    if (counting) matmul_perf_stop(perf, &counts);
+    matmul_perf_close(perf);
+    if (have_counts) print_perf_report(&counts, reps);
+
+    /* Nominal 2mkn operations (Strassen does fewer) and one pass over A, B and C. */
+    double flops = 2.0 * count * m * k * n;
+    double bytes = (double)count * ((m*k + k*n) * mat_dtype_size(dtype) + m*n * mat_dtype_size(out_dtype));
+    double gflops = timing.median > 0 ? flops / timing.median * 1e-9 : 0;
+    double gbps = timing.median > 0 ? bytes / timing.median * 1e-9 : 0;
+    if (!status && reps > 1) {
+        fprintf(stderr, "%d reps (+%d warmup): median %.6f s, p10 %.6f s, p90 %.6f s, mean %.6f s, stddev %.6f s\n"
+                        "%.3f GFLOP/s, %.3f GB/s effective\n",
+                reps, warmup, timing.median, timing.p10, timing.p90, timing.mean, timing.stddev, gflops, gbps);
+    }
+
+    if (d != mat_D.data) {
+        memcpy(mat_D.data, d, d_bytes);
+        MATMUL_NUMA_BUF bufs[] = {{"A", a, a_bytes}, {"B", b, b_bytes}, {"C", d, d_bytes}};
+        matmul_numa_report(stderr, bufs, 3, opts.threads);
+        matmul_numa_free((void*)a, a_bytes);
+        matmul_numa_free((void*)b, b_bytes);
+        matmul_numa_free(d, d_bytes);
+    }
+
+    double write_start = now();
+    if (!status && mat_save(&mat_D)) {
+        status = 1;
+    }
+    phases.write = now() - write_start;
+
+    if (thread_report) {
+        MATMUL_STATS st;
+        matmul_get_stats(&st);
+        print_thread_report(&st);
+    }
+
+    const char* label = batch ? "BATCH"
+                      : dtype != MATMUL_U32 ? matmul_dtype_label(dtype)
+                      : overflow != MATMUL_WRAP ? matmul_overflow_label(overflow)
+                      : matmul_algo_label(algo);
+    if (phases_path && !status) {
+        char size[64];
+        if (m == k && k == n) snprintf(size, sizeof(size), "%zu", n);
+        else snprintf(size, sizeof(size), "%zux%zux%zu", m, k, n);
+        if (write_phases(phases_path, label, size, reps, &phases)) perror("Failed to write phases");
+    }
+
+    /* a failed run has no samples; logging its zero median would read as a real one */
+    if (status) {
+        mat_close(&mat_A);
+        mat_close(&mat_B);
+        mat_close(&mat_D);
+        return status;
+    }
+
+    FILE* file_LOG = fopen(args[3], "a");
+    if (file_LOG) {
+        double elapsed = timing.median;
+        MATMUL_STATS st;
+        matmul_get_stats(&st);
+        if (m == k && k == n)
+            fprintf(file_LOG, "%s,%zu,%.9lf,%.9lf,%.9lf", label, n, elapsed, st.alloc_seconds, st.touch_seconds);
+        else
+            fprintf(file_LOG, "%s,%zux%zux%zu,%.9lf,%.9lf,%.9lf", label, m, k, n, elapsed,
+                    st.alloc_seconds, st.touch_seconds);
+        /* batches also log the number of products; the time covers all of them */
+        if (batch) fprintf(file_LOG, ",%zu", count);
+        fprintf(file_LOG, ",reps=%d,p10=%.9lf,p90=%.9lf,stddev=%.9lf,gflops=%.3lf,gbps=%.3lf",
+                timing.reps, timing.p10, timing.p90, timing.stddev, gflops, gbps);
+        if (have_counts) {
+            /* per-call counter columns, empty for events this machine can't count */
+            for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) {
+                fprintf(file_LOG, ",%s=", matmul_perf_event_name(e));
+                if (counts.total[e] != MATMUL_PERF_NA) fprintf(file_LOG, "%.0f", per_call(counts.total[e], reps));
+            }
+            uint64_t cyc = counts.total[MATMUL_PERF_CYCLES], ins = counts.total[MATMUL_PERF_INSTRUCTIONS];
+            fprintf(file_LOG, ",ipc=");
+            if (cyc && cyc != MATMUL_PERF_NA && ins != MATMUL_PERF_NA) fprintf(file_LOG, "%.3f", (double)ins / cyc);
+        }
+        fputc('\n', file_LOG);
+        fclose(file_LOG);
+    } else {
+        perror("Failed to open log file");
+    }
+
+    mat_close(&mat_A);
+    mat_close(&mat_B);
+    mat_close(&mat_D);
+
+    return status;
+}
@@ -0,0 +1,547 @@
+#include <getopt.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <mpi.h>
+
+#include "matio.h"
+#include "matmul.h"
+
+/*
+ * Distributed C = A * B over a 2D grid of MPI ranks, every rank running a
+ * lab1 kernel (--algo, packed by default) on its own tiles:
+ *
+ *   summa  - pr x pc grid, as square as the rank count allows.  k is walked
+ *            in panels: the owners broadcast a column panel of A along each
+ *            grid row and a row panel of B along each grid column, and the
+ *            next panel's broadcasts are in flight while the current one is
+ *            multiplied.
+ *   cannon - q x q grid.  After the initial skew, q steps of multiply, then
+ *            shift A left and B up; each shift overlaps the multiply.
+ *
+ * Inputs are u32 binary files.  Each rank reads only its tiles of A and B
+ * and writes only its tile of C, through MPI-IO subarray views, so no rank
+ * ever holds a whole matrix.  MPI counts are ints, so a layout with any
+ * tile, panel or matrix side over INT_MAX elements is refused up front.
+ */
+
+#define DEFAULT_PANEL 512
+
+typedef enum SCHEME {
+    SUMMA,
+    CANNON,
+} SCHEME;
+
+typedef struct GRID {
+    MPI_Comm comm;          /* 2D cartesian communicator */
+    MPI_Comm row, col;      /* my grid row (ranked by column) and column (ranked by row) */
+    int pr, pc;             /* grid shape */
+    int r, c;               /* my coordinates */
+} GRID;
+
+/* Time spent per phase on this rank. */
+typedef struct TIMES {
+    double read, compute, wait, write;
+    double alloc, touch;
+} TIMES;
+
+static void usage(const char* prog){
+    fprintf(stderr, "Usage: mpirun -np N %s [--scheme=summa|cannon] [--panel=N] [--algo=NAME] [--threads=N]\n"
+                    "       [--cutoff=N] [--leaf=NAME] [--perf] <A.bin> <B.bin> <output.bin> <logfile>\n"
+                    "       (cannon needs a square number of ranks)\n", prog);
+    fprintf(stderr, "Local algorithms:");
+    for (int i = 0; i < MATMUL_ALGO_COUNT; i++) fprintf(stderr, " %s", matmul_algo_name(i));
+    fputc('\n', stderr);
+}
+
+/* Part i of d split into `parts` near-equal pieces is [part_lo(i), part_lo(i + 1)). */
+static size_t part_lo(size_t d, int parts, int i){
+    return d * i / parts;
+}
+
+static size_t part_len(size_t d, int parts, int i){
+    return part_lo(d, parts, i + 1) - part_lo(d, parts, i);
+}
+
+static int part_of(size_t d, int parts, size_t x){
+    int i = 0;
+    while (part_lo(d, parts, i + 1) <= x) i++;
+    return i;
+}
+
+/*
+ * MPI counts and subarray extents are ints: every file extent, tile and
+ * panel this rank hands to MPI must be at most INT_MAX elements.
+ */
+static int int_counts(const MAT_HEADER* ha, const MAT_HEADER* hb, SCHEME scheme, size_t panel,
+                      size_t mr, size_t nc, size_t ka, size_t kb, size_t kmax){
+    size_t w = scheme == CANNON ? kmax : panel < ha->cols ? panel : ha->cols;
+    const size_t counts[] = {
+        ha->rows, ha->stride, hb->rows, hb->stride, hb->cols,   /* file views, C is m x n */
+        mr*ka, kb*nc, mr*nc,                                    /* tile reads and the write */
+        mr*w, w*nc,                                             /* broadcast panels, shifted blocks */
+    };
+    for (size_t i = 0; i < sizeof(counts) / sizeof(counts[0]); i++) {
+        if (counts[i] > INT_MAX) return 0;
+    }
+    return 1;
+}
+
+static void* alloc_or_die(size_t elems){
+    void* p = malloc(elems ? elems*sizeof(uint32_t) : 1);
+    if (!p) {
+        fprintf(stderr, "Memory allocation failed for a %zu element tile\n", elems);
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    return p;
+}
+
+/*
+ * File view selecting rows [r0, r0 + rows) x cols [c0, c0 + cols) of a
+ * matrix with `stride` elements per row.  Empty tiles get a plain view and
+ * move no data, but still take part in the collective call.
+ */
+static MPI_Datatype tile_view(const MAT_HEADER* h, size_t r0, size_t rows, size_t c0, size_t cols){
+    if (!rows || !cols) return MPI_UINT32_T;
+
+    int sizes[2] = {(int)h->rows, (int)h->stride};
+    int sub[2] = {(int)rows, (int)cols};
+    int starts[2] = {(int)r0, (int)c0};
+    MPI_Datatype view;
+    MPI_Type_create_subarray(2, sizes, sub, starts, MPI_ORDER_C, MPI_UINT32_T, &view);
+    MPI_Type_commit(&view);
+    return view;
+}
+
+static int read_tile(const char* path, const MAT_HEADER* h, size_t r0, size_t rows, size_t c0, size_t cols,
+                     uint32_t* dst){
+    MPI_File fh;
+    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_RDONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) return -1;
+
+    MPI_Datatype view = tile_view(h, r0, rows, c0, cols);
+    MPI_File_set_view(fh, h->header_size, MPI_UINT32_T, view, "native", MPI_INFO_NULL);
+    int rc = MPI_File_read_all(fh, dst, (int)(rows*cols), MPI_UINT32_T, MPI_STATUS_IGNORE);
+    if (view != MPI_UINT32_T) MPI_Type_free(&view);
+    MPI_File_close(&fh);
+    return rc == MPI_SUCCESS ? 0 : -1;
+}
+
+static int write_tile(const char* path, size_t m, size_t n, size_t r0, size_t rows, size_t c0, size_t cols,
+                      const uint32_t* src){
+    MPI_File fh;
+    if (MPI_File_open(MPI_COMM_WORLD, path, MPI_MODE_CREATE | MPI_MODE_WRONLY, MPI_INFO_NULL, &fh) != MPI_SUCCESS) {
+        return -1;
+    }
+    MPI_File_set_size(fh, MAT_HEADER_SIZE + m*n*sizeof(uint32_t));
+
+    MAT_HEADER h = {0};
+    memcpy(h.magic, MAT_MAGIC, 4);
+    h.version = MAT_VERSION;
+    h.dtype = MAT_U32;
+    h.header_size = MAT_HEADER_SIZE;
+    h.alignment = MAT_ALIGN;
+    h.rows = m;
+    h.cols = n;
+    h.stride = n;
+    h.count = 1;
+
+    int rank, rc = MPI_SUCCESS;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (!rank) rc = MPI_File_write_at(fh, 0, &h, sizeof(h), MPI_BYTE, MPI_STATUS_IGNORE);
+
+    MPI_Datatype view = tile_view(&h, r0, rows, c0, cols);
+    MPI_File_set_view(fh, MAT_HEADER_SIZE, MPI_UINT32_T, view, "native", MPI_INFO_NULL);
+    if (MPI_File_write_all(fh, src, (int)(rows*cols), MPI_UINT32_T, MPI_STATUS_IGNORE) != MPI_SUCCESS) rc = -1;
+    if (view != MPI_UINT32_T) MPI_Type_free(&view);
+    MPI_File_close(&fh);
+    return rc == MPI_SUCCESS ? 0 : -1;
+}
+
+/* C (+)= A * B on this rank; the first product of a run overwrites C. */
+static void local_mm(const uint32_t* A, const uint32_t* B, uint32_t* C, uint32_t* tmp, int first,
+                     size_t m, size_t k, size_t n, MATMUL_ALGO algo, const MATMUL_OPTS* opts, TIMES* t){
+    double t0 = MPI_Wtime();
+    if (matmul_mkn(A, B, first ? C : tmp, m, k, n, algo, opts)) {
+        perror("Local matmul failed");
+        MPI_Abort(MPI_COMM_WORLD, 1);
+    }
+    if (!first) {
+        #pragma omp parallel for schedule(static)
+        for(size_t i = 0; i < m*n; i++) C[i] += tmp[i];
+    }
+    MATMUL_STATS st;
+    matmul_get_stats(&st);
+    t->alloc += st.alloc_seconds;
+    t->touch += st.touch_seconds;
+    t->compute += MPI_Wtime() - t0;
+}
+
+typedef struct PANELS {
+    uint32_t* A[2];         /* mr x w column panels of A */
+    uint32_t* B[2];         /* w x nc row panels of B */
+    MPI_Request req[2][2];
+} PANELS;
+
+/*
+ * Starts the broadcasts of the panel [x, x + w) into slot s: its owners
+ * copy it out of their tiles, everyone else receives it.
+ */
+static void post_panel(const GRID* g, PANELS* p, int s, const uint32_t* A, size_t ka, size_t a_lo,
+                       const uint32_t* B, size_t b_lo, size_t mr, size_t nc, size_t k, size_t x, size_t w){
+    int aroot = part_of(k, g->pc, x), broot = part_of(k, g->pr, x);
+    if (g->c == aroot) {
+        for(size_t i = 0; i < mr; i++) memcpy(p->A[s] + i*w, A + i*ka + x - a_lo, w*sizeof(uint32_t));
+    }
+    if (g->r == broot) memcpy(p->B[s], B + (x - b_lo)*nc, w*nc*sizeof(uint32_t));
+    MPI_Ibcast(p->A[s], (int)(mr*w), MPI_UINT32_T, aroot, g->row, &p->req[s][0]);
+    MPI_Ibcast(p->B[s], (int)(w*nc), MPI_UINT32_T, broot, g->col, &p->req[s][1]);
+}
+
+/* End of the SUMMA panel starting at x: at most `panel` wide, within one owner of A and of B. */
+static size_t panel_end(const GRID* g, size_t k, size_t x, size_t panel){
+    size_t end = x + panel < k ? x + panel : k;
+    size_t a_end = part_lo(k, g->pc, part_of(k, g->pc, x) + 1);
+    size_t b_end = part_lo(k, g->pr, part_of(k, g->pr, x) + 1);
+    if (a_end < end) end = a_end;
+    if (b_end < end) end = b_end;
+    return end;
+}
+
+/*
+ * A is this rank's mr x ka tile of A (columns split over grid columns), B
+ * its kb x nc tile of B (rows split over grid rows).
+ */
+static void summa(const GRID* g, const uint32_t* A, const uint32_t* B, uint32_t* C,
+                  size_t m, size_t k, size_t n, size_t panel, MATMUL_ALGO algo, const MATMUL_OPTS* opts, TIMES* t){
+    size_t mr = part_len(m, g->pr, g->r), nc = part_len(n, g->pc, g->c);
+    size_t ka = part_len(k, g->pc, g->c), a_lo = part_lo(k, g->pc, g->c);
+    size_t b_lo = part_lo(k, g->pr, g->r);
+
+    if (!k) {
+        memset(C, 0, mr*nc*sizeof(uint32_t));
+        return;
+    }
+    if (panel > k) panel = k;
+
+    PANELS p;
+    for (int s = 0; s < 2; s++) {
+        p.A[s] = alloc_or_die(mr*panel);
+        p.B[s] = alloc_or_die(panel*nc);
+    }
+    uint32_t* tmp = alloc_or_die(mr*nc);
+
+    size_t x = 0, w = panel_end(g, k, 0, panel);
+    post_panel(g, &p, 0, A, ka, a_lo, B, b_lo, mr, nc, k, x, w);
+    for(int s = 0; x < k; s++){
+        size_t nx = x + w, nw = nx < k ? panel_end(g, k, nx, panel) - nx : 0;
+        if (nx < k) post_panel(g, &p, (s + 1) & 1, A, ka, a_lo, B, b_lo, mr, nc, k, nx, nw);
+
+        double t0 = MPI_Wtime();
+        MPI_Waitall(2, p.req[s & 1], MPI_STATUSES_IGNORE);
+        t->wait += MPI_Wtime() - t0;
+
+        local_mm(p.A[s & 1], p.B[s & 1], C, tmp, s == 0, mr, w, nc, algo, opts, t);
+        x = nx;
+        w = nw;
+    }
+
+    for (int s = 0; s < 2; s++) {
+        free(p.A[s]);
+        free(p.B[s]);
+    }
+    free(tmp);
+}
+
+/*
+ * q x q grid; k is split into q parts for both the columns of A and the
+ * rows of B, so rank (r, c) starts with A(r, c) and B(r, c).  At step s it
+ * holds A(r, l) and B(l, c) with l = (r + c + s) mod q.  *pA and *pB have
+ * room for the largest block and are swapped with second buffers as the
+ * blocks move, so they may point elsewhere on return.
+ */
+static void cannon(const GRID* g, uint32_t** pA, uint32_t** pB, uint32_t* C,
+                   size_t m, size_t k, size_t n, MATMUL_ALGO algo, const MATMUL_OPTS* opts, TIMES* t){
+    int q = g->pr, r = g->r, c = g->c;
+    uint32_t *A = *pA, *B = *pB;
+    size_t mr = part_len(m, q, r), nc = part_len(n, q, c);
+    size_t kmax = (k + q - 1) / q;
+
+    if (!k) {
+        memset(C, 0, mr*nc*sizeof(uint32_t));
+        return;
+    }
+
+    uint32_t* An = alloc_or_die(mr*kmax);
+    uint32_t* Bn = alloc_or_die(kmax*nc);
+    uint32_t* tmp = alloc_or_die(mr*nc);
+    uint32_t* swap;
+
+    /* Skew: A(r, c) moves r columns left, B(r, c) moves c rows up. */
+    double t0 = MPI_Wtime();
+    int l = (r + c) % q;
+    if (r) {
+        MPI_Sendrecv(A, (int)(mr*part_len(k, q, c)), MPI_UINT32_T, (c - r + q) % q, 0,
+                     An, (int)(mr*part_len(k, q, l)), MPI_UINT32_T, l, 0, g->row, MPI_STATUS_IGNORE);
+        swap = A; A = An; An = swap;
+    }
+    if (c) {
+        MPI_Sendrecv(B, (int)(part_len(k, q, r)*nc), MPI_UINT32_T, (r - c + q) % q, 1,
+                     Bn, (int)(part_len(k, q, l)*nc), MPI_UINT32_T, l, 1, g->col, MPI_STATUS_IGNORE);
+        swap = B; B = Bn; Bn = swap;
+    }
+    t->wait += MPI_Wtime() - t0;
+
+    for(int s = 0; s < q; s++){
+        size_t kl = part_len(k, q, l);
+        int next = (l + 1) % q;
+        MPI_Request req[4];
+        int shifts = s + 1 < q;
+        if (shifts) {
+            MPI_Isend(A, (int)(mr*kl), MPI_UINT32_T, (c - 1 + q) % q, 2, g->row, &req[0]);
+            MPI_Irecv(An, (int)(mr*part_len(k, q, next)), MPI_UINT32_T, (c + 1) % q, 2, g->row, &req[1]);
+            MPI_Isend(B, (int)(kl*nc), MPI_UINT32_T, (r - 1 + q) % q, 3, g->col, &req[2]);
+            MPI_Irecv(Bn, (int)(part_len(k, q, next)*nc), MPI_UINT32_T, (r + 1) % q, 3, g->col, &req[3]);
+        }
+
+        local_mm(A, B, C, tmp, s == 0, mr, kl, nc, algo, opts, t);
+
+        if (shifts) {
+            t0 = MPI_Wtime();
+            MPI_Waitall(4, req, MPI_STATUSES_IGNORE);
+            t->wait += MPI_Wtime() - t0;
+            swap = A; A = An; An = swap;
+            swap = B; B = Bn; Bn = swap;
+        }
+        l = next;
+    }
+
+    *pA = A;
+    *pB = B;
+    free(An);
+    free(Bn);
+    free(tmp);
+}
+
+/* Rank 0 validates both headers; everyone gets them or a failure. */
+static int load_headers(const char* a_path, const char* b_path, MAT_HEADER* ha, MAT_HEADER* hb){
+    int rank, ok = 1;
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    if (!rank) {
+        ok = !mat_read_header(a_path, ha) && !mat_read_header(b_path, hb);
+        if (ok && (ha->dtype != MAT_U32 || hb->dtype != MAT_U32 || ha->count > 1 || hb->count > 1)) {
+            fprintf(stderr, "Distributed matmul needs single u32 matrices\n");
+            ok = 0;
+        }
+        if (ok && ha->cols != hb->rows) {
+            fprintf(stderr, "Matrix size mismatch: A=%zux%zu B=%zux%zu\n",
+                    (size_t)ha->rows, (size_t)ha->cols, (size_t)hb->rows, (size_t)hb->cols);
+            ok = 0;
+        }
+    }
+    MPI_Bcast(&ok, 1, MPI_INT, 0, MPI_COMM_WORLD);
+    MPI_Bcast(ha, sizeof(*ha), MPI_BYTE, 0, MPI_COMM_WORLD);
+    MPI_Bcast(hb, sizeof(*hb), MPI_BYTE, 0, MPI_COMM_WORLD);
+    return ok ? 0 : -1;
+}
+
+static void make_grid(GRID* g, int ranks){
+    int dims[2] = {0, 0}, periods[2] = {0, 0}, coords[2], rank;
+    MPI_Dims_create(ranks, 2, dims);
+    MPI_Cart_create(MPI_COMM_WORLD, 2, dims, periods, 0, &g->comm);
+    MPI_Comm_rank(g->comm, &rank);
+    MPI_Cart_coords(g->comm, rank, 2, coords);
+
+    int keep_row[2] = {0, 1}, keep_col[2] = {1, 0};
+    MPI_Cart_sub(g->comm, keep_row, &g->row);
+    MPI_Cart_sub(g->comm, keep_col, &g->col);
+    g->pr = dims[0];
+    g->pc = dims[1];
+    g->r = coords[0];
+    g->c = coords[1];
+}
+
+int main(int argc, char** argv){
+    static const struct option long_opts[] = {
+        {"scheme",  required_argument, NULL, 'S'},
+        {"panel",   required_argument, NULL, 'p'},
+        {"algo",    required_argument, NULL, 'a'},
+        {"threads", required_argument, NULL, 't'},
+        {"cutoff",  required_argument, NULL, 'c'},
+        {"leaf",    required_argument, NULL, 'l'},
+        {"perf",    no_argument,       NULL, 'P'},
+        {"help",    no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    int provided, ranks, rank;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_FUNNELED, &provided);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+
+    SCHEME scheme = SUMMA;
+    MATMUL_ALGO algo = MATMUL_PACKED;
+    MATMUL_OPTS opts = {0};
+    size_t panel = DEFAULT_PANEL;
+    int perf_counters = 0;
+
+    int opt, bad = 0;
+    while ((opt = getopt_long(argc, argv, "a:t:c:l:p:h", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'S':
+            if (!strcmp(optarg, "summa")) scheme = SUMMA;
+            else if (!strcmp(optarg, "cannon")) scheme = CANNON;
+            else bad = 1;
+            break;
+        case 'p':
+            panel = strtoull(optarg, NULL, 10);
+            if (!panel) bad = 1;
+            break;
+        case 'a':
+            algo = matmul_algo_from_name(optarg);
+            if (algo == MATMUL_ALGO_COUNT) bad = 1;
+            break;
+        case 't':
+            opts.threads = atoi(optarg);
+            break;
+        case 'c':
+            opts.cutoff = strtoull(optarg, NULL, 10);
+            break;
+        case 'l':
+            opts.leaf = matmul_leaf_from_name(optarg);
+            if (opts.leaf == MATMUL_LEAF_COUNT) bad = 1;
+            break;
+        case 'P':
+            perf_counters = 1;
+            break;
+        default:
+            bad = 1;
+            break;
+        }
+    }
+    if (bad || argc - optind < 4) {
+        if (!rank) usage(argv[0]);
+        MPI_Finalize();
+        return 1;
+    }
+    char** args = argv + optind;
+
+    int dims[2] = {0, 0};
+    MPI_Dims_create(ranks, 2, dims);
+    if (scheme == CANNON && dims[0] != dims[1]) {
+        if (!rank) fprintf(stderr, "Cannon needs a square number of ranks, got %d\n", ranks);
+        MPI_Finalize();
+        return 1;
+    }
+
+    MAT_HEADER ha, hb;
+    if (load_headers(args[0], args[1], &ha, &hb)) {
+        MPI_Finalize();
+        return 1;
+    }
+    size_t m = ha.rows, k = ha.cols, n = hb.cols;
+
+    /* A's columns are split over grid columns, B's rows over grid rows. */
+    GRID g;
+    make_grid(&g, ranks);
+    size_t mr = part_len(m, g.pr, g.r), nc = part_len(n, g.pc, g.c);
+    size_t ka = part_len(k, g.pc, g.c), kb = part_len(k, g.pr, g.r);
+    size_t kmax = (k + g.pr - 1) / g.pr;
+
+    int too_big = !int_counts(&ha, &hb, scheme, panel, mr, nc, ka, kb, kmax);
+    MPI_Allreduce(MPI_IN_PLACE, &too_big, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    if (too_big) {
+        if (!rank) fprintf(stderr, "%zux%zux%zu on a %dx%d grid needs MPI counts above INT_MAX; "
+                                   "use more ranks or a smaller --panel\n", m, k, n, g.pr, g.pc);
+        MPI_Finalize();
+        return 1;
+    }
+
+    TIMES t = {0};
+    uint32_t* A = alloc_or_die(scheme == CANNON ? mr*kmax : mr*ka);
+    uint32_t* B = alloc_or_die(scheme == CANNON ? kmax*nc : kb*nc);
+    uint32_t* C = alloc_or_die(mr*nc);
+
+    double t0 = MPI_Wtime();
+    int failed = read_tile(args[0], &ha, part_lo(m, g.pr, g.r), mr, part_lo(k, g.pc, g.c), ka, A)
+              || read_tile(args[1], &hb, part_lo(k, g.pr, g.r), kb, part_lo(n, g.pc, g.c), nc, B);
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    if (failed) {
+        if (!rank) fprintf(stderr, "Failed to read the input tiles\n");
+        MPI_Finalize();
+        return 1;
+    }
+    t.read = MPI_Wtime() - t0;
+
+    MATMUL_PERF* perf = perf_counters ? matmul_perf_open(opts.threads) : NULL;
+    if (perf_counters && !perf && !rank) perror("Hardware counters unavailable");
+
+    MPI_Barrier(MPI_COMM_WORLD);
+    double start = MPI_Wtime();
+    if (perf) matmul_perf_start(perf);
+    if (scheme == SUMMA) summa(&g, A, B, C, m, k, n, panel, algo, &opts, &t);
+    else                 cannon(&g, &A, &B, C, m, k, n, algo, &opts, &t);
+    free(A);
+    free(B);
+    MATMUL_PERF_COUNTS counts;
+    if (perf) matmul_perf_stop(perf, &counts);
+    MPI_Barrier(MPI_COMM_WORLD);
+    double elapsed = MPI_Wtime() - start;
+
+    /* Counter totals over all ranks; an event counts only if every rank could. */
+    uint64_t events[MATMUL_PERF_EVENT_COUNT] = {0};
+    int counted[MATMUL_PERF_EVENT_COUNT] = {0};
+    if (perf_counters) {
+        for (int e = 0; e < MATMUL_PERF_EVENT_COUNT; e++) {
+            counted[e] = perf && counts.total[e] != MATMUL_PERF_NA;
+            events[e] = counted[e] ? counts.total[e] : 0;
+        }
+        MPI_Allreduce(MPI_IN_PLACE, events, MATMUL_PERF_EVENT_COUNT, MPI_UINT64_T, MPI_SUM, MPI_COMM_WORLD);
+        MPI_Allreduce(MPI_IN_PLACE, counted, MATMUL_PERF_EVENT_COUNT, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+        matmul_perf_close(perf);
+    }
+
+    t0 = MPI_Wtime();
+    failed = write_tile(args[2], m, n, part_lo(m, g.pr, g.r), mr, part_lo(n, g.pc, g.c), nc, C);
+    MPI_Allreduce(MPI_IN_PLACE, &failed, 1, MPI_INT, MPI_LOR, MPI_COMM_WORLD);
+    t.write = MPI_Wtime() - t0;
+    free(C);
+
+    TIMES worst;
+    MPI_Reduce(&t, &worst, sizeof(t) / sizeof(double), MPI_DOUBLE, MPI_MAX, 0, MPI_COMM_WORLD);
+    if (!rank) {
+        if (failed) fprintf(stderr, "Failed to write %s\n", args[2]);
+        fprintf(stderr, "[mpi] %s on a %dx%d grid, slowest rank: read %.3f s, compute %.3f s, "
+                        "comm wait %.3f s, write %.3f s\n", scheme == SUMMA ? "summa" : "cannon",
+                g.pr, g.pc, worst.read, worst.compute, worst.wait, worst.write);
+
+        FILE* file_LOG = fopen(args[3], "a");
+        if (file_LOG) {
+            const char* label = matmul_algo_label(algo);
+            const char* prefix = scheme == SUMMA ? "SUMMA" : "CANNON";
+            if (m == k && k == n)
+                fprintf(file_LOG, "%s_%s,%zu,%.9lf,%.9lf,%.9lf,%d", prefix, label, n, elapsed,
+                        worst.alloc, worst.touch, ranks);
+            else
+                fprintf(file_LOG, "%s_%s,%zux%zux%zu,%.9lf,%.9lf,%.9lf,%d", prefix, label, m, k, n, elapsed,
+                        worst.alloc, worst.touch, ranks);
+            for (int e = 0; perf_counters && e < MATMUL_PERF_EVENT_COUNT; e++) {
+                fprintf(file_LOG, ",%s=", matmul_perf_event_name(e));
+                if (counted[e]) fprintf(file_LOG, "%" PRIu64, events[e]);
+            }
+            if (perf_counters) {
+                fprintf(file_LOG, ",ipc=");
+                if (counted[MATMUL_PERF_CYCLES] && counted[MATMUL_PERF_INSTRUCTIONS] && events[MATMUL_PERF_CYCLES])
+                    fprintf(file_LOG, "%.3f", (double)events[MATMUL_PERF_INSTRUCTIONS] / events[MATMUL_PERF_CYCLES]);
+            }
+            fputc('\n', file_LOG);
+            fclose(file_LOG);
+        } else {
+            perror("Failed to open log file");
+        }
+    }
+
+    MPI_Finalize();
+    return failed ? 1 : 0;
+}
@@ -0,0 +1,197 @@
+#include <getopt.h>
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <omp.h>
+
+#include "matio.h"
+
+/*
+ * Checks D = A*B without multiplying: Freivalds' test compares A*(B*R)
+ * with D*R for a random n x r matrix R, r = --rounds, which costs
+ * O(r*(m*k + k*n + m*n)) instead of O(m*k*n).  The arithmetic is done mod
+ * 2^64 and compared mod 2^32 for 32 bit outputs, the same wraparound the
+ * kernels have (exact64 outputs are compared mod 2^64).
+ *
+ * A wrong entry of D survives one round with probability at most 1/2
+ * (only when it is off by a multiple of 2^31), 2^-32 for a typical error,
+ * so the default 16 rounds leave at most 2^-16 either way.
+ *
+ * Exit status: 0 verified, 1 mismatch, 2 bad arguments or inputs.
+ */
+
+#define DEFAULT_ROUNDS 16
+
+static double now(void){
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return (double)t.tv_sec + (double)t.tv_nsec*1e-9;
+}
+
+static uint64_t splitmix64(uint64_t* state){
+    uint64_t z = (*state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+static int is_integer(int dtype){
+    return dtype != MAT_F32 && dtype != MAT_F64 && mat_dtype_size(dtype);
+}
+
+/* Row `i` of matrix `b` of a batch as uint64_t; signed types are sign extended (two's complement mod 2^64). */
+static void widen(const MAT_FILE* f, size_t b, size_t i, uint64_t* out){
+    size_t off = (b*f->rows + i)*f->cols;
+    for(size_t j = 0; j < f->cols; j++){
+        switch (f->dtype) {
+        case MAT_U64: out[j] = ((const uint64_t*)f->data)[off + j]; break;
+        case MAT_U8:  out[j] = ((const uint8_t*)f->data)[off + j]; break;
+        case MAT_I16: out[j] = (uint64_t)(int64_t)((const int16_t*)f->data)[off + j]; break;
+        case MAT_I32: out[j] = (uint64_t)(int64_t)((const int32_t*)f->data)[off + j]; break;
+        default:      out[j] = ((const uint32_t*)f->data)[off + j]; break;
+        }
+    }
+}
+
+/* Y = M*X mod 2^64 for matrix `b` of M; X is M->cols x k and Y is M->rows x k, both row-major. */
+static int times(const MAT_FILE* M, size_t b, const uint64_t* X, uint64_t* Y, size_t k){
+    int failed = 0;
+    #pragma omp parallel reduction(|:failed)
+    {
+        uint64_t* row = malloc(M->cols*sizeof(uint64_t));
+        if (!row) failed = 1;
+        #pragma omp for schedule(static)
+        for(size_t i = 0; i < M->rows; i++){
+            if (!row) continue;
+            uint64_t* y = Y + i*k;
+            memset(y, 0, k*sizeof(uint64_t));
+            widen(M, b, i, row);
+            for(size_t j = 0; j < M->cols; j++){
+                const uint64_t* x = X + j*k;
+                for(size_t r = 0; r < k; r++){
+                    y[r] += row[j]*x[r];
+                }
+            }
+        }
+        free(row);
+    }
+    return failed ? -1 : 0;
+}
+
+static void usage(const char* prog){
+    fprintf(stderr, "Usage: %s [--rounds=K] [--seed=N] [--threads=N] <A.dat|A.bin> <B.dat|B.bin> <D.dat|D.bin>\n"
+                    "       checks D = A*B (mod 2^32, or 2^64 for exact64 outputs) with Freivalds' test\n", prog);
+}
+
+int main(int argc, char** argv){
+    static struct option long_opts[] = {
+        {"rounds",  required_argument, NULL, 'k'},
+        {"seed",    required_argument, NULL, 's'},
+        {"threads", required_argument, NULL, 't'},
+        {"help",    no_argument,       NULL, 'h'},
+        {NULL, 0, NULL, 0},
+    };
+
+    size_t rounds = DEFAULT_ROUNDS;
+    uint64_t seed = (uint64_t)time(NULL) ^ (uint64_t)clock();
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "k:s:t:h", long_opts, NULL)) != -1) {
+        switch (opt) {
+        case 'k':
+            rounds = strtoull(optarg, NULL, 10);
+            if (!rounds) rounds = 1;
+            break;
+        case 's':
+            seed = strtoull(optarg, NULL, 10);
+            break;
+        case 't':
+            if (atoi(optarg) > 0) omp_set_num_threads(atoi(optarg));
+            break;
+        default:
+            usage(argv[0]);
+            return 2;
+        }
+    }
+    if (argc - optind < 3) {
+        usage(argv[0]);
+        return 2;
+    }
+    char** args = argv + optind;
+
+    double start = now();
+    MAT_FILE mat_A, mat_B, mat_D;
+    if (mat_load(args[0], &mat_A)) {
+        return 2;
+    }
+    if (mat_load(args[1], &mat_B)) {
+        mat_close(&mat_A);
+        return 2;
+    }
+    if (mat_load(args[2], &mat_D)) {
+        mat_close(&mat_A);
+        mat_close(&mat_B);
+        return 2;
+    }
+
+    int status = 2;
+    size_t m = mat_A.rows, k = mat_A.cols, n = mat_B.cols;
+    size_t count = mat_A.count;
+    uint64_t* R = NULL, *Y = NULL, *Z = NULL, *W = NULL;
+    if (!is_integer(mat_A.dtype) || !is_integer(mat_B.dtype) || !is_integer(mat_D.dtype)) {
+        fprintf(stderr, "Only integer matrices can be verified\n");
+        goto done;
+    }
+    if (mat_B.rows != k || mat_D.rows != m || mat_D.cols != n
+        || mat_B.count != count || mat_D.count != count) {
+        fprintf(stderr, "Shapes do not match: A %zux%zu, B %zux%zu, D %zux%zu (batches %zu, %zu, %zu)\n",
+                m, k, mat_B.rows, n, mat_D.rows, mat_D.cols, count, mat_B.count, mat_D.count);
+        goto done;
+    }
+
+    R = malloc(n*rounds*sizeof(uint64_t));
+    Y = malloc(k*rounds*sizeof(uint64_t));
+    Z = malloc(m*rounds*sizeof(uint64_t));
+    W = malloc(m*rounds*sizeof(uint64_t));
+    if (!R || !Y || !Z || !W) {
+        fprintf(stderr, "Memory allocation failed for %zu rounds\n", rounds);
+        goto done;
+    }
+
+    uint64_t mask = mat_dtype_size(mat_D.dtype) == sizeof(uint64_t) ? UINT64_MAX : UINT32_MAX;
+    uint64_t state = seed;
+    status = 0;
+    for(size_t b = 0; b < count && !status; b++){
+        for(size_t i = 0; i < n*rounds; i++){
+            R[i] = splitmix64(&state);
+        }
+        if (times(&mat_B, b, R, Y, rounds) || times(&mat_A, b, Y, Z, rounds) || times(&mat_D, b, R, W, rounds)) {
+            fprintf(stderr, "Memory allocation failed\n");
+            status = 2;
+            break;
+        }
+        for(size_t i = 0; i < m*rounds; i++){
+            if ((Z[i] ^ W[i]) & mask) {
+                printf("VERIFY %s FAILED matrix=%zu row=%zu rounds=%zu seed=%" PRIu64 "\n",
+                       args[2], b, i / rounds, rounds, seed);
+                status = 1;
+                break;
+            }
+        }
+    }
+    if (!status) {
+        printf("VERIFY %s OK rounds=%zu seconds=%.6f\n", args[2], rounds, now() - start);
+    }
+
+done:
+    free(R);
+    free(Y);
+    free(Z);
+    free(W);
+    mat_close(&mat_A);
+    mat_close(&mat_B);
+    mat_close(&mat_D);
+    return status;
+}
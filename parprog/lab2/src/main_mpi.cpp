@@ -1,9 +1,12 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <chrono>
 #include <cmath>
 #include <mpi.h>
 
+#include "perf_counters.hpp"
+
 #define ISIZE 5000
 #define JSIZE 5000
 
@@ -39,6 +42,9 @@ int main(int argc, char *argv[])
 
     // std::cout << rank << " " << to_count << " " << rank * to_count << std::endl;
 
+    perf::Counters perf;
+    perf.start();
+
     if (rank == 0)
     {
         auto start = std::chrono::high_resolution_clock::now();
@@ -59,7 +65,7 @@ int main(int argc, char *argv[])
 
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << std::endl;
+        std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000;
     }
     else if (rank < commsize - 1)
     {
@@ -88,8 +94,27 @@ int main(int argc, char *argv[])
         MPI_Send(a[rank * to_count], ISIZE * JSIZE - (to_count * JSIZE * (commsize - 1)), MPI_DOUBLE, 0, 0, MPI_COMM_WORLD);
     }
 
+    // Counter columns are summed over all ranks and end rank 0's timing line;
+    // an event is left empty unless every rank could count it.
+    perf.stop();
+    perf::Counts counts;
+    std::array<int, perf::EventCount> counted;
+    for (int e = 0; e < perf::EventCount; e++)
+    {
+        counted[e] = perf.totals()[e] >= 0;
+        counts[e] = counted[e] ? perf.totals()[e] : 0;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, counts.data(), perf::EventCount, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, counted.data(), perf::EventCount, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    for (int e = 0; e < perf::EventCount; e++)
+    {
+        counts[e] = counted[e] ? counts[e] : -1;
+    }
+
     if (rank == 0)
     {
+        std::cout << (perf.enabled() ? perf::Counters::csv(counts) : "") << std::endl;
+
         if (argc > 1)
         {
             ff.open(argv[1]);
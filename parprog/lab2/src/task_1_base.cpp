@@ -1,8 +1,11 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <chrono>
 #include <cmath>
 
+#include "perf_counters.hpp"
+
 #define ISIZE 5000
 #define JSIZE 5000
 
@@ -28,6 +31,8 @@ int main(int argc, char **argv)
         }
     }
 
+    perf::Counters perf;
+    perf.start();
     auto start = std::chrono::high_resolution_clock::now();
 
     for (i = 2; i < ISIZE; i++)
@@ -38,8 +43,9 @@ int main(int argc, char **argv)
         }
     }
     auto end = std::chrono::high_resolution_clock::now();
+    perf.stop();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << std::endl;
+    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << perf.csv() << std::endl;
 
     if (argc > 1)
     {
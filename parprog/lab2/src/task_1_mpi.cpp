@@ -1,9 +1,12 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <chrono>
 #include <cmath>
 #include <mpi.h>
 
+#include "perf_counters.hpp"
+
 #define ISIZE 5000
 #define JSIZE 5000
 
@@ -93,6 +96,8 @@ int main(int argc, char **argv)
         }
     }
 
+    perf::Counters perf;
+    perf.start();
     auto start = std::chrono::high_resolution_clock::now();
 
     if (rank % 2 == 0)
@@ -122,12 +127,14 @@ int main(int argc, char **argv)
         }
     }
 
+    perf.stop();
+
     if (rank == 0)
     {
 
         auto end = std::chrono::high_resolution_clock::now();
         auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-        std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << std::endl;
+        std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000;
 
         if (argc > 1)
         {
@@ -145,6 +152,26 @@ int main(int argc, char **argv)
         }
     }
 
+    // Counter columns are summed over all ranks and end rank 0's timing line;
+    // an event is left empty unless every rank could count it.
+    perf::Counts counts;
+    std::array<int, perf::EventCount> counted;
+    for (int e = 0; e < perf::EventCount; e++)
+    {
+        counted[e] = perf.totals()[e] >= 0;
+        counts[e] = counted[e] ? perf.totals()[e] : 0;
+    }
+    MPI_Allreduce(MPI_IN_PLACE, counts.data(), perf::EventCount, MPI_INT64_T, MPI_SUM, MPI_COMM_WORLD);
+    MPI_Allreduce(MPI_IN_PLACE, counted.data(), perf::EventCount, MPI_INT, MPI_LAND, MPI_COMM_WORLD);
+    for (int e = 0; e < perf::EventCount; e++)
+    {
+        counts[e] = counted[e] ? counts[e] : -1;
+    }
+    if (rank == 0)
+    {
+        std::cout << (perf.enabled() ? perf::Counters::csv(counts) : "") << std::endl;
+    }
+
     MPI_Finalize();
 
     delete[] a[0];
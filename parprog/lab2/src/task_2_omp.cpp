@@ -1,9 +1,12 @@
 #include <iostream>
 #include <fstream>
+#include <iomanip>
 #include <chrono>
 #include <cmath>
 #include <omp.h>
 
+#include "perf_counters.hpp"
+
 #define ISIZE 5000
 #define JSIZE 5000
 
@@ -44,6 +47,8 @@ int main(int argc, char **argv)
         }
     }
 
+    perf::Counters perf;
+    perf.start();
     auto start = std::chrono::high_resolution_clock::now();
 
 #pragma omp parallel for
@@ -53,8 +58,9 @@ int main(int argc, char **argv)
     }
 
     auto end = std::chrono::high_resolution_clock::now();
+    perf.stop();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
-    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << std::endl;
+    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << perf.csv() << std::endl;
 
     if (argc > 1)
     {
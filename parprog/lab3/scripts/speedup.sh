@@ -53,12 +53,13 @@ current_step=0
 for (( n=START_N; n<=END_N; n+=STEP_N )); do
     # Run Binary 1
     # We grab the LAST line of stdout, assuming it is the time
+    # (its first field: PERF_COUNTERS=1 appends counter columns)
     out1=$("$BIN1" "$B_VAL" "$n" 2>/dev/null)
-    time1=$(echo "$out1" | tail -n 1)
+    time1=$(echo "$out1" | tail -n 1 | cut -d, -f1)
 
     # Run Binary 2
     out2=$("$BIN2" "$B_VAL" "$n" 2>/dev/null)
-    time2=$(echo "$out2" | tail -n 1)
+    time2=$(echo "$out2" | tail -n 1 | cut -d, -f1)
 
     # Calculate Speedup (Time1 / Time2) using awk for safety with floats
     if (( $(echo "$time2 == 0" | bc -l) )); then
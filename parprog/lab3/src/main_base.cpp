@@ -4,6 +4,8 @@
 #include <iomanip>
 #include <iostream>
 
+#include "perf_counters.hpp"
+
 double get_element(double *a, ssize_t i, ssize_t size) {
     if (i < 0)
         return 0;
@@ -74,6 +76,8 @@ int main(int argc, char *argv[]){
 
     const ssize_t N = total_points - 2; // interior points
 
+    perf::Counters perf;
+    perf.start();
     auto start = std::chrono::high_resolution_clock::now();
     double *diag_0 = new double[N - 1];
     double *diag_1 = new double[N];
@@ -125,9 +129,10 @@ int main(int argc, char *argv[]){
     }
 
     auto end = std::chrono::high_resolution_clock::now();
+    perf.stop();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     std::cout << "Iterations: " << iteration << std::endl;
-    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << std::endl;
+    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << perf.csv() << std::endl;
 
     std::cerr << 0.0 << ", " << left_boundary << "\n";
     for (ssize_t i = 0; i < N; i++)
@@ -6,6 +6,8 @@
 #include <vector>
 #include <omp.h>
 
+#include "perf_counters.hpp"
+
 struct CyclicReductionSolver {
     std::vector<double*> a_levels; // lower diagonal
     std::vector<double*> b_levels; // main 
@@ -193,6 +195,8 @@ int main(int argc, char *argv[]){
         y[i] = left_boundary + (right_boundary - left_boundary) * t;
     }
 
+    perf::Counters perf;
+    perf.start();
     auto start = std::chrono::high_resolution_clock::now();
     double max_err = eps * 2;
     ssize_t iteration = 0;
@@ -236,9 +240,10 @@ int main(int argc, char *argv[]){
     }
 
     auto end = std::chrono::high_resolution_clock::now();
+    perf.stop();
     auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end - start);
     std::cout << "Iterations: " << iteration << std::endl;
-    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << std::endl;
+    std::cout << duration.count() / 1000000 << "." << std::setfill('0') << std::setw(6) << duration.count() % 1000000 << perf.csv() << std::endl;
     
     std::cerr << 0.0 << ", " << left_boundary << "\n";
     for (ssize_t i = 0; i < N; i++)